@@ -0,0 +1,517 @@
+/**
+ * OlympusCamera-RemoteControl: end-to-end benchmarks
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "benchmark.h"
+#include "../main.h"
+#include "../rtpdatagramhandler.h"
+#include "../liveviewdecoder.h"
+#include "../cameraproperties.h"
+#include "../commandlist.h"
+#include "../simulator/camerasimulator.h"
+#include "../simulator/liveviewstreamer.h"
+#include "recordedstream.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <time.h>
+#include <common/mvc/View.h>		// Separate git-repo
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+// -----------------------------------------------------------------------
+// Class CReplayDecoder
+// Consumer of a replay: takes the published frames in its own thread and
+// decodes them, like the GUI does. Frames published while it is decoding
+// are superseded, i.e. dropped.
+// -----------------------------------------------------------------------
+class CReplayDecoder : public mvc::View {
+public:
+	CReplayDecoder(CRTPDatagramHandler * pHandler, const QSize & displaySize)
+		: m_pHandler(pHandler), m_DisplaySize(displaySize), m_FramePublished(false), m_Stop(false), m_DecodedFrames(0) {
+		registerAt(m_pHandler, false);
+		m_Thread = std::thread(&CReplayDecoder::run, this);
+	}
+	/** Decodes the last published frame and stops the thread */
+	void finish() {
+		{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+		}
+		m_Condition.notify_one();
+		m_Thread.join();
+		unregisterAt(m_pHandler);
+	}
+	/** Inherited from View, invoked by the feeding thread */
+	virtual void update(const mvc::Model *, void *) override {
+		{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_FramePublished = true;
+		}
+		m_Condition.notify_one();
+	}
+	int		getDecodedFrames() const { return m_DecodedFrames; }
+	const CLatencyHistogram & getDecodeTimes() const { return m_DecodeTimes; }
+	const CLatencyHistogram & getFrameLatencies() const { return m_FrameLatencies; }
+private:
+	void run() {
+		while (true) {
+			{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this] { return m_FramePublished || m_Stop; });
+			if (!m_FramePublished && m_Stop)
+				break;
+			m_FramePublished = false;
+			}
+			CFrameBuffer * pFrame;
+			while ((pFrame = m_pHandler->takeFrame()) != nullptr) {
+				const int64_t startTime = CLatencyClock::now();
+				const QImage  image     = CLiveViewDecoder::decodeScaled(pFrame->getData(), m_DisplaySize);
+				const int64_t endTime   = CLatencyClock::now();
+				m_DecodeTimes.add(endTime - startTime);
+				m_FrameLatencies.add(endTime - pFrame->getFirstPacketTime());
+				m_pHandler->releaseFrame(pFrame);
+				if (!image.isNull())
+					m_DecodedFrames++;
+				}
+			}
+	}
+
+	CRTPDatagramHandler *	m_pHandler;
+	QSize					m_DisplaySize;
+	std::thread				m_Thread;
+	std::mutex				m_Mutex;
+	std::condition_variable	m_Condition;
+	bool					m_FramePublished;
+	bool					m_Stop;
+	int						m_DecodedFrames;
+	CLatencyHistogram		m_DecodeTimes;		// Decoder thread until finish()
+	CLatencyHistogram		m_FrameLatencies;	// First packet -> decoded
+};
+
+const int PARSE_ITERATIONS = 2000;
+
+// -----------------------------------------------------------------------
+// The former parsing by string search, as reference: the reply is copied
+// into a std::string, each element of a <desc> is searched separately.
+// -----------------------------------------------------------------------
+bool getElementBySearch(const std::string & text, size_t begin, size_t end, const char * tag, std::string & content) {
+	const std::string openTag  = std::string("<") + tag + ">";
+	const std::string closeTag = std::string("</") + tag + ">";
+	const size_t idx1 = text.find(openTag, begin);
+	if (idx1 == std::string::npos || idx1 >= end)
+		return false;
+	const size_t idx2 = text.find(closeTag, idx1);
+	if (idx2 == std::string::npos || idx2 > end)
+		return false;
+	content = text.substr(idx1 + openTag.size(), idx2 - idx1 - openTag.size());
+	return true;
+}
+
+// -----------------------------------------------------------------------
+int parsePropertiesBySearch(const QByteArray & buffer, std::map<std::string, CCameraProperty> & properties) {
+	const std::string reply = buffer.toStdString();
+	int    count = 0;
+	size_t pos   = 0;
+	while ((pos = reply.find("<desc>", pos)) != std::string::npos) {
+		const size_t end = reply.find("</desc>", pos);
+		if (end == std::string::npos)
+			break;
+		std::string name;
+		if (getElementBySearch(reply, pos, end, "propname", name) && !name.empty()) {
+			CCameraProperty & property = properties[name];
+			property.name = name;
+			std::string attribute;
+			getElementBySearch(reply, pos, end, "attribute", attribute);
+			property.access = (attribute == "getset") ? CCameraProperty::ECPA_GetSet : (attribute == "get") ? CCameraProperty::ECPA_Get :
+							  (attribute == "set") ? CCameraProperty::ECPA_Set : CCameraProperty::ECPA_None;
+			getElementBySearch(reply, pos, end, "value", property.value);
+			std::string enumeration;
+			property.enumValues.clear();
+			if (getElementBySearch(reply, pos, end, "enum", enumeration)) {
+				size_t first = 0;
+				while ((first = enumeration.find_first_not_of(' ', first)) != std::string::npos) {
+					size_t last = enumeration.find(' ', first);
+					if (last == std::string::npos) last = enumeration.size();
+					property.enumValues.push_back(enumeration.substr(first, last - first));
+					first = last;
+					}
+				}
+			count++;
+			}
+		pos = end + 7;
+		}
+	return count;
+}
+
+// -----------------------------------------------------------------------
+// A reply of propname=desclist like the one of an E-M1: 60 properties
+QByteArray createDescList() {
+	QByteArray reply("<?xml version=\"1.0\"?>\r\n<desclist>\r\n");
+	for (int i = 0; i < 60; i++) {
+		reply += "<desc>\r\n<propname>property" + QByteArray::number(i) + "</propname>\r\n";
+		reply += (i % 3 == 0) ? "<attribute>get</attribute>\r\n" : "<attribute>getset</attribute>\r\n";
+		reply += "<value>" + QByteArray::number(i * 10) + "</value>\r\n";
+		if (i % 3 != 0) {
+			reply += "<enum>";
+			for (int j = 0; j < 24; j++)
+				reply += QByteArray::number(j * 10) + ' ';
+			reply += "</enum>\r\n";
+			}
+		reply += "</desc>\r\n";
+		}
+	return reply + "</desclist>\r\n";
+}
+
+// -----------------------------------------------------------------------
+// A reply of get_commandlist like the one of a TG-6: 50 CGIs with two levels
+QByteArray createCommandList() {
+	QByteArray reply("<?xml version=\"1.0\"?>\r\n<oishare>\r\n<version>4.20</version>\r\n<support func=\"web\"/>\r\n");
+	for (int i = 0; i < 50; i++) {
+		reply += "<cgi name=\"cgi" + QByteArray::number(i) + "\">\r\n<http_method type=\"get\">\r\n<cmd1 name=\"com\">\r\n";
+		for (int j = 0; j < 3; j++) {
+			reply += "<param1 name=\"param" + QByteArray::number(j) + "\">\r\n<cmd2 name=\"propname\">\r\n";
+			for (int k = 0; k < 8; k++)
+				reply += "<param2 name=\"value" + QByteArray::number(k) + "\"/>\r\n";
+			reply += "</cmd2>\r\n</param1>\r\n";
+			}
+		reply += "</cmd1>\r\n</http_method>\r\n</cgi>\r\n";
+		}
+	reply += "<cgi name=\"get_camprop\">\r\n<http_method type=\"get\">\r\n<cmd1 name=\"com\">\r\n<param1 name=\"desc\">\r\n"
+			 "<cmd2 name=\"propname\">\r\n<param2 name=\"shutspeedvalue\"/>\r\n<param2 name=\"desclist\"/>\r\n</cmd2>\r\n"
+			 "</param1>\r\n</cmd1>\r\n</http_method>\r\n</cgi>\r\n";
+	return reply + "</oishare>\r\n";
+}
+}
+
+// -----------------------------------------------------------------------
+// Class CBenchmark
+// -----------------------------------------------------------------------
+CBenchmark::CBenchmark(CCameraSimulator * pSimulator, QObject * pParent)
+	: QObject(pParent), m_pSimulator(pSimulator), m_Frames(DEFAULT_FRAMES), m_Iterations(DEFAULT_ITERATIONS),
+	  m_State(Init), m_StateTime(0), m_SecondPushTime(0) {
+	if (m_pSimulator != nullptr) // Not needed by runReplay()
+		connect(m_pSimulator, SIGNAL(requestReceived(QString)), this, SLOT(requestReceived(QString)));
+}
+
+// -----------------------------------------------------------------------
+void CBenchmark::runLiveView() {
+	const QSize displaySize(640, 480);
+	const ELiveViewQuality qualities[] = { ELVQ_0320x0240, ELVQ_0640x0480, ELVQ_0800x0600, ELVQ_1024x0768, ELVQ_1280x0960 };
+	for (ELiveViewQuality quality : qualities) {
+		const QSize frameSize = CRTPDatagramHandler::getFrameSize(quality);
+		CLiveViewStreamer streamer;
+		std::vector<QByteArray> images;
+		for (unsigned int i = 0; i < CLiveViewStreamer::FRAME_CYCLE; i++)
+			images.push_back(streamer.createImage(frameSize, i));
+		std::vector<std::vector<QByteArray>> frames;
+		for (int i = 0; i < m_Frames; i++)
+			frames.push_back(streamer.packetize(images[i % images.size()]));
+
+		CRTPDatagramHandler handler;
+		handler.setLiveViewQuality(quality);
+		CFrameAnalyzer analyzer;	// Both overlays, on a copy of the decoded image
+		analyzer.setFocusPeakingEnabled(true);
+		analyzer.setHistogramEnabled(true);
+		int64_t reassemblyTime = 0, decodeTime = 0, analysisTime = 0;
+		int     decodedFrames  = 0;
+		unsigned long long analysisAllocations = 0;
+		const unsigned long long allocations = g_Allocations;
+		const int64_t cpuTime   = getThreadCpuTime();
+		const int64_t startTime = CLatencyClock::now();
+		for (const auto & packets : frames) {
+			const int64_t t0 = CLatencyClock::now();
+			for (const QByteArray & packet : packets)
+				handler.processDatagram(packet);
+			CFrameBuffer * pFrame = handler.takeFrame();
+			const int64_t t1 = CLatencyClock::now();
+			reassemblyTime += t1 - t0;
+			if (pFrame == nullptr)
+				continue;
+			const QImage image = CLiveViewDecoder::decodeScaled(pFrame->getData(), displaySize);
+			handler.releaseFrame(pFrame);
+			const int64_t t2 = CLatencyClock::now();
+			decodeTime += t2 - t1;
+			if (image.isNull())
+				continue;
+			decodedFrames++;
+			const unsigned long long a = g_Allocations;
+			QImage overlay = image;
+			analyzer.analyze(overlay);
+			analysisTime += CLatencyClock::now() - t2;
+			analysisAllocations += g_Allocations - a;
+			}
+		const double wallTime = (CLatencyClock::now() - startTime) / 1e9;
+		const int    count    = (decodedFrames > 0) ? decodedFrames : 1;
+
+		QJsonObject result;
+		result["name"]                  = "liveview.reassembly_decode";
+		result["lvqty"]                 = QString("%1x%2").arg(frameSize.width(), 4, 10, QChar('0')).arg(frameSize.height(), 4, 10, QChar('0'));
+		result["frames"]                = decodedFrames;
+		result["frames_per_second"]     = decodedFrames / wallTime;
+		result["cpu_us_per_frame"]      = (getThreadCpuTime() - cpuTime) / 1e3 / count;
+		result["reassembly_us_per_frame"] = reassemblyTime / 1e3 / count;
+		result["decode_us_per_frame"]   = decodeTime / 1e3 / count;
+		result["analysis_us_per_frame"] = analysisTime / 1e3 / count;
+		result["analysis_kernels"]      = CFrameAnalyzer::getKernelName();
+		result["allocations_per_frame"] = (double)(g_Allocations - allocations - analysisAllocations) / count;
+		result["complete_frames"]       = (int)handler.getStatistics().completeFrames;
+		m_Results.append(result);
+		qDebug("LiveView %s: %.1f frames/s", qPrintable(result["lvqty"].toString()), result["frames_per_second"].toDouble());
+		}
+}
+
+// -----------------------------------------------------------------------
+// The packets are fed by this thread at their recorded time (scaled by
+// speed) resp. without pause, the frames are decoded by a CReplayDecoder.
+void CBenchmark::runReplay(const CRecordedStream & stream, double speed) {
+	const QSize displaySize(640, 480);
+	CRTPDatagramHandler handler;
+	handler.setLiveViewQuality(ELVQ_1280x0960);	// The largest frame buffers, the stream may have any "lvqty"
+	CReplayDecoder decoder(&handler, displaySize);
+	CLatencyHistogram feedLag;	// Behind the scheduled time of a packet
+	const int64_t cpuTime   = getThreadCpuTime();
+	const int64_t startTime = CLatencyClock::now();
+	for (const CRecordedStream::CPacket & packet : stream.getPackets()) {
+		if (speed > 0.0) {
+			const int64_t targetTime = startTime + (int64_t)(packet.time / speed);
+			std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(targetTime)));
+			feedLag.add(CLatencyClock::now() - targetTime);
+			}
+		handler.processDatagram(packet.data);
+		}
+	const int64_t feedTime = CLatencyClock::now() - startTime;
+	const int64_t feedCpu  = getThreadCpuTime() - cpuTime;
+	decoder.finish();
+	const double  wallTime = (CLatencyClock::now() - startTime) / 1e9;
+
+	const CRTPStatistics & stats = handler.getStatistics();
+	const int streamFrames       = stream.getFrames();
+	const int decodedFrames      = decoder.getDecodedFrames();
+	QJsonObject result;
+	result["name"]                 = "liveview.replay";
+	result["format"]               = stream.getFormat();
+	result["timing"]               = (speed <= 0.0) ? "as_fast_as_possible" : (speed == 1.0) ? "original" : "accelerated";
+	result["speed"]                = speed;
+	result["packets"]              = (int)stream.getPackets().size();
+	result["reassembled_datagrams"] = stream.getReassembledDatagrams();	// IPv4 fragments
+	result["skipped_fragments"]    = stream.getSkippedFragments();		// Not in the replay
+	result["stream_frames"]        = streamFrames;
+	result["stream_duration_s"]    = stream.getDuration() / 1e9;
+	result["wall_time_s"]          = wallTime;
+	result["lost_packets"]         = (int)stats.lostPackets;
+	result["reordered_packets"]    = (int)stats.reorderedPackets;
+	result["oversize_packets"]     = (int)stats.oversizePackets;
+	result["late_packets"]         = (int)stats.latePackets;
+	result["complete_frames"]      = (int)stats.completeFrames;
+	result["incomplete_frames"]    = (int)stats.incompleteFrames;
+	result["dropped_frames"]       = (int)stats.droppedFrames;		// No free buffer
+	result["superseded_frames"]    = (int)stats.supersededFrames;	// Decoder busy
+	result["decoded_frames"]       = decodedFrames;
+	result["decoded_frames_per_second"] = decodedFrames / wallTime;
+	result["drop_percent"]         = (streamFrames > 0) ? 100.0 * (streamFrames - decodedFrames) / streamFrames : 0.0;
+	result["reassembly_cpu_us_per_packet"] = stream.getPackets().empty() ? 0.0 : feedCpu / 1e3 / stream.getPackets().size();
+	result["feed_time_s"]          = feedTime / 1e9;
+	result["decode_us_p50"]        = decoder.getDecodeTimes().getPercentile(50.0) / 1e3;
+	result["decode_us_p95"]        = decoder.getDecodeTimes().getPercentile(95.0) / 1e3;
+	result["decode_us_max"]        = decoder.getDecodeTimes().getMax() / 1e3;
+	result["frame_latency_ms_p50"] = decoder.getFrameLatencies().getPercentile(50.0) / 1e6;
+	result["frame_latency_ms_p95"] = decoder.getFrameLatencies().getPercentile(95.0) / 1e6;
+	if (speed > 0.0)
+		result["feed_lag_us_p99"]  = feedLag.getPercentile(99.0) / 1e3;
+	m_Results.append(result);
+	qDebug("Replay %s: %d of %d frames decoded (%.1f frames/s), %u superseded, %u incomplete",
+		   qPrintable(result["timing"].toString()), decodedFrames, streamFrames, decodedFrames / wallTime,
+		   stats.supersededFrames, stats.incompleteFrames);
+}
+
+// -----------------------------------------------------------------------
+// The replies of get_camprop?com=desc&propname=desclist and get_commandlist,
+// parsed in place by the pull parser resp. by the former string search
+void CBenchmark::runReplyParsing() {
+	const QByteArray descList    = createDescList();
+	const QByteArray commandList = createCommandList();
+	CCameraPropertyTable table;
+	std::map<std::string, CCameraProperty> properties;
+	CCommandList list;
+	bool hasShutterSpeedValue = false, hasDescList = false;
+	table.parse(descList.constData(), descList.size());	// Warm up: the properties are known, as with polling
+	parsePropertiesBySearch(descList, properties);
+
+	for (int method = 0; method < 4; method++) {
+		int count = 0;
+		const unsigned long long allocations = g_Allocations;
+		const int64_t startTime = CLatencyClock::now();
+		for (int i = 0; i < PARSE_ITERATIONS; i++) {
+			switch (method) {
+				case 0:	count = table.parse(descList.constData(), descList.size());
+						break;
+				case 1:	count = parsePropertiesBySearch(descList, properties);
+						break;
+				case 2:	count = list.parse(commandList.constData(), commandList.size());
+						hasShutterSpeedValue = list.hasParameter("get_camprop", "propname", "shutspeedvalue");
+						hasDescList          = list.hasParameter("get_camprop", "propname", "desclist");
+						break;
+				default: {
+						const std::string reply = commandList.toStdString();
+						hasShutterSpeedValue = reply.find("shutspeedvalue") != std::string::npos;
+						hasDescList          = reply.find("\"desclist\"") != std::string::npos;
+						count                = hasShutterSpeedValue + hasDescList;
+						} break;
+				}
+			}
+		const double time = (CLatencyClock::now() - startTime) / 1e3 / PARSE_ITERATIONS;
+
+		QJsonObject result;
+		result["name"]   = (method < 2) ? "parse.desclist" : "parse.commandlist";
+		result["method"] = (method % 2 == 0) ? "pull_parser" : "string_search";
+		result["reply_bytes"]           = (method < 2) ? descList.size() : commandList.size();
+		result["us_per_reply"]          = time;
+		result["allocations_per_reply"] = (double)(g_Allocations - allocations) / PARSE_ITERATIONS;
+		result["elements"]              = count;	// Properties, CGIs resp. found names
+		result["valid"]                 = (method < 2) ? (count == 60) : (hasShutterSpeedValue && hasDescList);
+		m_Results.append(result);
+		qDebug("%s %s: %.2f us", qPrintable(result["name"].toString()), qPrintable(result["method"].toString()), time);
+		}
+}
+
+// -----------------------------------------------------------------------
+bool CBenchmark::runPropertyRefresh(CMainController * pController) {
+	CLatencyHistogram histogram;
+	if (!waitFor([pController]() { return !pController->hasPendingCommands(); }))
+		return false;
+	const quint64 connections = m_pSimulator->getAcceptedConnections();
+	const quint64 requests    = m_pSimulator->getRequests();
+	for (int i = 0; i < m_Iterations; i++) {
+		if (!waitFor([pController]() { return !pController->hasPendingCommands(); }))
+			return false;
+		const int64_t startTime = CLatencyClock::now();
+		QMetaObject::invokeMethod(pController, "_requestExposureProperties", Qt::DirectConnection);
+		if (!waitFor([pController]() { return !pController->hasPendingCommands(); }))
+			return false;
+		histogram.add(CLatencyClock::now() - startTime);
+		}
+	m_Results.append(toJson("command.property_refresh", histogram));
+
+	const qint64 newRequests    = (qint64)(m_pSimulator->getRequests() - requests);
+	const qint64 newConnections = (qint64)(m_pSimulator->getAcceptedConnections() - connections);
+	QJsonObject reuse; // New connections of the keep-alive pool during the refreshes
+	reuse["name"]        = "command.connection_reuse";
+	reuse["requests"]    = newRequests;
+	reuse["connections"] = newConnections;
+	m_Results.append(reuse);
+	qDebug("Property refresh: p50 %.2f ms, %lld requests, %lld new connections", histogram.getPercentile(50.0) / 1e6,
+		   (long long)newRequests, (long long)newConnections);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+bool CBenchmark::runStateMachine(CMainController * pController) {
+	CLatencyHistogram focusLatency, triggerLatency;
+	for (int i = 0; i < m_Iterations; i++) {
+		if (!waitFor([this, pController]() { return m_State == Init && !pController->hasPendingCommands(); }))
+			return false;
+
+		int64_t startTime = CLatencyClock::now();
+		pController->focusButtonClicked(true);
+		if (!waitFor([this]() { return m_State == Focussed; }))
+			return false;
+		focusLatency.add(m_StateTime - startTime);
+
+		startTime = CLatencyClock::now();
+		pController->shutterButtonPressed();
+		if (!waitFor([this, startTime]() { return m_SecondPushTime >= startTime && m_State == Triggered; }))
+			return false;
+		triggerLatency.add(m_SecondPushTime - startTime);
+
+		pController->shutterButtonReleased();
+		if (!waitFor([this]() { return m_State == Focussed; }))
+			return false;
+		pController->focusButtonClicked(false);
+		}
+	m_Results.append(toJson("statemachine.focus_to_focussed", focusLatency));
+	m_Results.append(toJson("statemachine.shutter_to_2ndpush", triggerLatency));
+	qDebug("Focus: p50 %.2f ms, shutter: p50 %.2f ms", focusLatency.getPercentile(50.0) / 1e6, triggerLatency.getPercentile(50.0) / 1e6);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: state of CMainStateMachine, emitted by CQMLBackend
+void CBenchmark::cameraStatusChanged(QVariant state) {
+	m_State     = state.toInt();
+	m_StateTime = CLatencyClock::now();
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: request received by the simulator
+void CBenchmark::requestReceived(QString request) {
+	if (request == "exec_shutter?com=2ndpush")
+		m_SecondPushTime = CLatencyClock::now();
+}
+
+// -----------------------------------------------------------------------
+// Processes events until the condition is met, false on timeout
+bool CBenchmark::waitFor(const std::function<bool()> & condition, int timeout) {
+	const int64_t endTime = CLatencyClock::now() + (int64_t)timeout * 1000000;
+	while (!condition()) {
+		if (CLatencyClock::now() > endTime) {
+			qWarning("Benchmark: timeout");
+			return false;
+			}
+		QCoreApplication::processEvents(QEventLoop::AllEvents);
+		QThread::usleep(20);
+		}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+QJsonObject CBenchmark::toJson(const QString & name, const CLatencyHistogram & histogram) {
+	QJsonObject result;
+	result["name"]    = name;
+	result["count"]   = (qint64)histogram.getCount();
+	result["p50_ms"]  = histogram.getPercentile(50.0) / 1e6;
+	result["p95_ms"]  = histogram.getPercentile(95.0) / 1e6;
+	result["p99_ms"]  = histogram.getPercentile(99.0) / 1e6;
+	result["max_ms"]  = histogram.getMax() / 1e6;
+	return result;
+}
+
+// -----------------------------------------------------------------------
+int64_t CBenchmark::getThreadCpuTime() {
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return (int64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+}}} // End namespaces
@@ -0,0 +1,99 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_BENCHMARK_BENCHMARK_H
+#define DE_BSWALZ_OLYCAMERARC_BENCHMARK_BENCHMARK_H
+
+/**
+ * OlympusCamera-RemoteControl: end-to-end benchmarks
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "../latencystatistics.h"
+#include <QObject>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QVariant>
+#include <atomic>
+#include <functional>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+class CCameraSimulator;
+class CMainController;
+class CRecordedStream;
+
+/** Calls of malloc(), calloc() and realloc(), counted by main.cpp */
+extern std::atomic<unsigned long long> g_Allocations;
+
+// -----------------------------------------------------------------------
+// Class CBenchmark
+// Runs the LiveView path and the command pipeline against the simulator
+// and collects the results as JSON for regression tracking.
+// -----------------------------------------------------------------------
+class CBenchmark : public QObject {
+	Q_OBJECT
+public:
+	static const int DEFAULT_FRAMES     = 300;		// Per "lvqty"
+	static const int DEFAULT_ITERATIONS = 50;
+	static const int TIMEOUT            = 5000;		// ms per step
+
+	CBenchmark(CCameraSimulator *, QObject * pParent = nullptr);
+	void	setFrames(int frames) { m_Frames = frames; }
+	void	setIterations(int iterations) { m_Iterations = iterations; }
+
+	/** RTP reassembly (CRTPDatagramHandler) and decode of each "lvqty" */
+	void	runLiveView();
+	/** Replay of a recorded stream: speed 1 original timing, > 1 accelerated, 0 as fast as possible */
+	void	runReplay(const CRecordedStream &, double speed);
+	/** Parsing of the desclist and command list replies, pull parser vs. string search */
+	void	runReplyParsing();
+	/** Full refresh of the exposure properties through processCameraCommand()/httpFinished() */
+	bool	runPropertyRefresh(CMainController *);
+	/** Focus button to state "Focussed", shutter button to the arrival of "2ndpush" */
+	bool	runStateMachine(CMainController *);
+
+	const QJsonArray & getResults() const { return m_Results; }
+
+protected slots:
+	void	cameraStatusChanged(QVariant);
+	void	requestReceived(QString);
+
+private:
+	bool	waitFor(const std::function<bool()> & condition, int timeout = TIMEOUT);
+	static QJsonObject toJson(const QString & name, const CLatencyHistogram &);
+	static int64_t getThreadCpuTime();
+
+	CCameraSimulator *	m_pSimulator;
+	QJsonArray			m_Results;
+	int					m_Frames;
+	int					m_Iterations;
+	int					m_State;			// EState
+	int64_t				m_StateTime;		// CLatencyClock
+	int64_t				m_SecondPushTime;	// CLatencyClock
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_BENCHMARK_BENCHMARK_H
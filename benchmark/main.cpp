@@ -0,0 +1,162 @@
+/**
+ * OlympusCamera-RemoteControl: benchmark runner
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "benchmark.h"
+#include "recordedstream.h"
+#include "../main.h"
+#include "../simulator/camerasimulator.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QWidget>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+std::atomic<unsigned long long> g_Allocations(0);
+}}} // End namespaces
+
+// -----------------------------------------------------------------------
+// Counting allocator (glibc): all allocations of Qt and of the application
+// -----------------------------------------------------------------------
+#if defined(__GLIBC__)
+extern "C" {
+void * __libc_malloc(size_t);
+void * __libc_calloc(size_t, size_t);
+void * __libc_realloc(void *, size_t);
+void   __libc_free(void *);
+
+void * malloc(size_t size) {
+	de::bswalz::olycamerarc::g_Allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+void * calloc(size_t count, size_t size) {
+	de::bswalz::olycamerarc::g_Allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+void * realloc(void * p, size_t size) {
+	de::bswalz::olycamerarc::g_Allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(p, size);
+}
+void free(void * p) {
+	__libc_free(p);
+}
+}
+#endif
+
+// -----------------------------------------------------------------------
+// To the file of option "output" resp. standard output
+// -----------------------------------------------------------------------
+static bool writeResults(const QCommandLineParser & parser, const QByteArray & json) {
+	if (parser.isSet("output")) {
+		QFile file(parser.value("output"));
+		return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(json) == json.size();
+		}
+	fwrite(json.constData(), 1, json.size(), stdout);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	QApplication app(argc, argv);
+	QCoreApplication::setApplicationName("OlyCamera-Benchmark");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("End-to-end benchmarks of OlyCamera-RC against the camera simulator, results as JSON.");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "output",     "JSON file of the results (default: standard output).", "file" },
+		{ "latency",    "Latency of the simulated camera in ms (default 5).",   "ms",    "5" },
+		{ "accept-delay", "Additional latency of the first reply of a connection in ms (default 50).", "ms", "50" },
+		{ "frames",     "LiveView frames per lvqty (default 300).",             "count", "300" },
+		{ "iterations", "Iterations of the command benchmarks (default 50).",   "count", "50" },
+		{ "replay",     "Replays a recorded LiveView stream (pcap, pcapng, rtpdump) instead, no simulator.", "file" },
+		{ "replay-speed", "Timing of the replay: 1 original, > 1 accelerated, 0 as fast as possible (default 1).", "factor", "1" },
+		{ "replay-port",  "UDP destination port of the LiveView packets in a pcap (default: all).", "port", "0" } });
+	parser.process(app);
+
+	if (parser.isSet("replay")) { // Offline, e.g. a capture of "tcpdump -w liveview.pcap udp"
+		de::bswalz::olycamerarc::CRecordedStream stream;
+		if (!stream.load(parser.value("replay"), parser.value("replay-port").toInt())) {
+			fprintf(stderr, "%s: %s\n", qPrintable(parser.value("replay")), qPrintable(stream.getError()));
+			return 1;
+			}
+		if (!stream.getError().isEmpty()) // E.g. skipped fragments, their packets count as lost
+			fprintf(stderr, "%s: %s\n", qPrintable(parser.value("replay")), qPrintable(stream.getError()));
+		de::bswalz::olycamerarc::CBenchmark benchmark(nullptr);
+		benchmark.runReplay(stream, parser.value("replay-speed").toDouble());
+		QJsonObject document;
+		document["benchmark"]  = "OlyCamera-RC";
+		document["timestamp"]  = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+		document["qt_version"] = qVersion();
+		document["replay"]     = parser.value("replay");
+		document["complete"]   = true;
+		document["results"]    = benchmark.getResults();
+		return writeResults(parser, QJsonDocument(document).toJson()) ? 0 : 1;
+		}
+
+	de::bswalz::olycamerarc::CSimulatorConfig config;
+	config.httpPort = 0; // Any free port
+	config.latency  = parser.value("latency").toInt();
+	config.acceptDelay = parser.value("accept-delay").toInt();
+	de::bswalz::olycamerarc::CCameraSimulator simulator(config);
+	if (!simulator.start())
+		return 1;
+	qputenv("OLYCAMERARC_CAMERA_ADDRESS", QString("127.0.0.1:%1").arg(simulator.getPort()).toLatin1());
+
+	de::bswalz::olycamerarc::CBenchmark benchmark(&simulator);
+	benchmark.setFrames(parser.value("frames").toInt());
+	benchmark.setIterations(parser.value("iterations").toInt());
+	benchmark.runLiveView();
+	benchmark.runReplyParsing();
+
+	QWidget rootWidget;
+	de::bswalz::olycamerarc::CMainController * pController = de::bswalz::olycamerarc::CMainController::getInstance();
+	QObject::connect(pController->getQMLBackend(), SIGNAL(notifyCameraStatusChanged(QVariant)), &benchmark, SLOT(cameraStatusChanged(QVariant)));
+	pController->init(&app, &rootWidget);
+	const bool ok = benchmark.runPropertyRefresh(pController) && benchmark.runStateMachine(pController);
+	QMetaObject::invokeMethod(pController, "tearDown", Qt::DirectConnection);
+
+	QJsonObject document;
+	document["benchmark"]  = "OlyCamera-RC";
+	document["timestamp"]  = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+	document["qt_version"] = qVersion();
+	document["camera_latency_ms"] = config.latency;
+	document["camera_accept_delay_ms"] = config.acceptDelay;
+	document["complete"]   = ok;
+	document["results"]    = benchmark.getResults();
+	if (!writeResults(parser, QJsonDocument(document).toJson()))
+		return 1;
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,344 @@
+/**
+ * OlympusCamera-RemoteControl: recorded LiveView streams (pcap, rtpdump)
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+
+
+#include "recordedstream.h"
+#include <QFile>
+#include <algorithm>
+#include <string.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+// Link types of pcap resp. pcapng
+const int LINKTYPE_NULL      = 0;
+const int LINKTYPE_ETHERNET  = 1;
+const int LINKTYPE_RAW       = 101;
+const int LINKTYPE_LINUX_SLL = 113;
+const int LINKTYPE_IPV4      = 228;
+const int LINKTYPE_IPV6      = 229;
+const int LINKTYPE_LINUX_SLL2 = 276;
+
+uint16_t get16be(const char * p) { return (uint16_t)(((uint8_t)p[0] << 8) | (uint8_t)p[1]); }
+uint32_t get32be(const char * p) { return ((uint32_t)get16be(p) << 16) | get16be(p + 2); }
+uint32_t get32(const char * p, bool swapped) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return swapped ? __builtin_bswap32(value) : value;
+}
+uint16_t get16(const char * p, bool swapped) {
+	uint16_t value;
+	memcpy(&value, p, sizeof(value));
+	return swapped ? __builtin_bswap16(value) : value;
+}
+}
+
+// -----------------------------------------------------------------------
+// Class CRecordedStream
+// -----------------------------------------------------------------------
+bool CRecordedStream::load(const QString & fileName, int port) {
+	m_Port      = port;
+	m_Frames    = 0;
+	m_FirstTime = -1;
+	m_Packets.clear();
+	m_Fragments.clear();
+	m_ReassembledDatagrams = 0;
+	m_SkippedFragments     = 0;
+	m_Error.clear();
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		m_Error = file.errorString();
+		return false;
+		}
+	const QByteArray content = file.readAll();
+	if (content.size() < 24) {
+		m_Error = "File too short";
+		return false;
+		}
+	const uint32_t magic = get32(content.constData(), false);
+	bool ok;
+	if (magic == 0xA1B2C3D4 || magic == 0xD4C3B2A1 || magic == 0xA1B23C4D || magic == 0x4D3CB2A1)
+		ok = loadPcap(content);
+	else if (magic == 0x0A0D0D0A)
+		ok = loadPcapNg(content);
+	else if (content.startsWith("#!rtpplay1.0"))
+		ok = loadRtpDump(content);
+	else {
+		m_Error = "Unknown format";
+		ok = false;
+		}
+	for (const auto & entry : m_Fragments)	// Datagrams without all fragments
+		m_SkippedFragments += entry.second.count;
+	m_Fragments.clear();
+	if (m_SkippedFragments > 0) {
+		const QString skipped = QString("%1 IP fragments skipped").arg(m_SkippedFragments);
+		m_Error = m_Error.isEmpty() ? skipped : m_Error + ", " + skipped;
+		}
+	if (ok && m_Packets.empty()) {
+		m_Error = m_Error.isEmpty() ? QString("No RTP packets") : "No RTP packets (" + m_Error + ")";
+		ok = false;
+		}
+	return ok;
+}
+
+// -----------------------------------------------------------------------
+// Global header (24 bytes), then records: header (16 bytes) and data
+bool CRecordedStream::loadPcap(const QByteArray & content) {
+	const char * p         = content.constData();
+	const uint32_t magic   = get32(p, false);
+	const bool     swapped = (magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1);
+	const bool     nano    = (magic == 0xA1B23C4D || magic == 0x4D3CB2A1);
+	const int      linkType = (int)(get32(p + 20, swapped) & 0xFFFF);
+	m_Format = "pcap";
+	for (int offset = 24; offset + 16 <= content.size(); ) {
+		const int64_t  seconds  = get32(p + offset, swapped);
+		const int64_t  fraction = get32(p + offset + 4, swapped);
+		const uint32_t length   = get32(p + offset + 8, swapped);
+		offset += 16;
+		if (length > (uint32_t)(content.size() - offset)) {
+			m_Error = "Truncated record";
+			return !m_Packets.empty();
+			}
+		addFrame(linkType, seconds * 1000000000 + (nano ? fraction : fraction * 1000), p + offset, (int)length);
+		offset += (int)length;
+		}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Blocks: section header, interface descriptions (link type, time
+// resolution) and enhanced resp. simple packets
+bool CRecordedStream::loadPcapNg(const QByteArray & content) {
+	const char * p = content.constData();
+	bool swapped   = false;
+	std::vector<std::pair<int, int64_t>> interfaces;	// Link type, time units per second
+	m_Format = "pcapng";
+	for (int offset = 0; offset + 12 <= content.size(); ) {
+		uint32_t type = get32(p + offset, swapped);
+		if (type == 0x0A0D0D0A) {	// Section header: byte order of the section
+			swapped = get32(p + offset + 8, false) != 0x1A2B3C4D;
+			interfaces.clear();
+			}
+		const uint32_t length = get32(p + offset + 4, swapped);
+		if (length < 12 || length > (uint32_t)(content.size() - offset)) {
+			m_Error = "Truncated block";
+			return !m_Packets.empty();
+			}
+		const char * pBody = p + offset + 8;
+		const int    size  = (int)length - 12;
+		if (type == 1 && size >= 8) {	// Interface description
+			int64_t resolution = 1000000;
+			for (int o = 8; o + 4 <= size; ) {	// Options
+				const int code = get16(pBody + o, swapped);
+				const int len  = get16(pBody + o + 2, swapped);
+				if (code == 0)
+					break;
+				if (code == 9 && len >= 1) { // if_tsresol
+					const uint8_t value = (uint8_t)pBody[o + 4];
+					resolution = 1;
+					for (int i = 0; i < (value & 0x7F); i++)
+						resolution *= (value & 0x80) ? 2 : 10;
+					}
+				o += 4 + ((len + 3) & ~3);
+				}
+			interfaces.push_back(std::make_pair((int)get16(pBody, swapped), resolution));
+			}
+		else if (type == 6 && size >= 20) {	// Enhanced packet
+			const uint32_t interface = get32(pBody, swapped);
+			const uint64_t units     = ((uint64_t)get32(pBody + 4, swapped) << 32) | get32(pBody + 8, swapped);
+			const uint32_t captured  = get32(pBody + 12, swapped);
+			if (interface < interfaces.size() && captured <= (uint32_t)(size - 20)) {
+				const int64_t resolution = interfaces[interface].second;
+				const int64_t time = (int64_t)(units / resolution) * 1000000000 + (int64_t)(units % resolution) * 1000000000 / resolution;
+				addFrame(interfaces[interface].first, time, pBody + 20, (int)captured);
+				}
+			}
+		else if (type == 3 && size >= 4 && !interfaces.empty()) {	// Simple packet, no time stamp
+			const uint32_t original = get32(pBody, swapped);
+			addFrame(interfaces[0].first, 0, pBody + 4, (int)((original < (uint32_t)(size - 4)) ? original : size - 4));
+			}
+		offset += (int)length;
+		}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Text line, file header (16 bytes), then packets: length (incl. the
+// 8 bytes of the packet header), RTP length (0: RTCP), time in ms
+bool CRecordedStream::loadRtpDump(const QByteArray & content) {
+	const char * p = content.constData();
+	m_Format = "rtpdump";
+	int offset = content.indexOf('\n');
+	if (offset < 0 || offset + 1 + 16 > content.size()) {
+		m_Error = "Truncated header";
+		return false;
+		}
+	for (offset += 1 + 16; offset + 8 <= content.size(); ) {
+		const int length    = get16be(p + offset);
+		const int rtpLength = get16be(p + offset + 2);
+		const int64_t time  = (int64_t)get32be(p + offset + 4) * 1000000;
+		if (length < 8 || offset + length > content.size()) {
+			m_Error = "Truncated packet";
+			return !m_Packets.empty();
+			}
+		if (rtpLength > 0)
+			addPacket(time, p + offset + 8, (rtpLength < length - 8) ? rtpLength : length - 8);
+		offset += length;
+		}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Takes the UDP payload of a captured frame
+void CRecordedStream::addFrame(int linkType, int64_t time, const char * pData, int size) {
+	int offset = 0;
+	int ipVersion = 0;
+	switch (linkType) {
+		case LINKTYPE_ETHERNET : {
+					if (size < 14)
+						return;
+					uint16_t etherType = get16be(pData + 12);
+					offset = 14;
+					while (etherType == 0x8100 && offset + 4 <= size) { // VLAN tags
+						etherType = get16be(pData + offset + 2);
+						offset += 4;
+						}
+					ipVersion = (etherType == 0x0800) ? 4 : (etherType == 0x86DD) ? 6 : 0;
+					} break;
+		case LINKTYPE_LINUX_SLL :
+					if (size < 16)
+						return;
+					offset    = 16;
+					ipVersion = (get16be(pData + 14) == 0x0800) ? 4 : (get16be(pData + 14) == 0x86DD) ? 6 : 0;
+					break;
+		case LINKTYPE_LINUX_SLL2 :
+					if (size < 20)
+						return;
+					offset    = 20;
+					ipVersion = (get16be(pData) == 0x0800) ? 4 : (get16be(pData) == 0x86DD) ? 6 : 0;
+					break;
+		case LINKTYPE_NULL :	// Address family in host byte order of the capturing machine
+					offset = 4;
+					if (size > 4) ipVersion = (uint8_t)pData[4] >> 4;
+					break;
+		case LINKTYPE_RAW :
+		case LINKTYPE_IPV4 :
+		case LINKTYPE_IPV6 :
+					if (size > 0) ipVersion = (uint8_t)pData[0] >> 4;
+					break;
+		default:	return;
+		}
+
+	if (ipVersion == 4) {
+		if (offset + 20 > size)
+			return;
+		const int headerLength = ((uint8_t)pData[offset] & 0x0F) * 4;
+		const int totalLength  = get16be(pData + offset + 2);
+		if ((uint8_t)pData[offset + 9] != 17 || headerLength < 20 || offset + headerLength > size) // UDP
+			return;
+		// Without the link layer padding resp. as far as captured
+		const int end = (totalLength >= headerLength && offset + totalLength < size) ? offset + totalLength : size;
+		if ((get16be(pData + offset + 6) & 0x3FFF) != 0) { // More fragments or fragment offset
+			addFragment(time, pData + offset, pData + offset + headerLength, end - offset - headerLength);
+			return;
+			}
+		addDatagram(time, pData + offset + headerLength, end - offset - headerLength);
+		}
+	else if (ipVersion == 6) {
+		if (offset + 40 > size)
+			return;
+		if ((uint8_t)pData[offset + 6] == 44) // Fragment header
+			m_SkippedFragments++;
+		else if ((uint8_t)pData[offset + 6] == 17)
+			addDatagram(time, pData + offset + 40, size - offset - 40);
+		}
+}
+
+// -----------------------------------------------------------------------
+// Collects the fragments of an IPv4 datagram, the complete datagram is
+// taken at the time of its last fragment. pHeader: IPv4 header
+void CRecordedStream::addFragment(int64_t time, const char * pHeader, const char * pPayload, int size) {
+	const uint16_t flags  = get16be(pHeader + 6);
+	const int      offset = (flags & 0x1FFF) * 8;
+	const FragmentKey key(((uint64_t)get32be(pHeader + 12) << 32) | get32be(pHeader + 16),
+						  ((uint32_t)get16be(pHeader + 4) << 16) | (uint8_t)pHeader[9]);
+	CFragments & fragments = m_Fragments[key];
+	fragments.count++;
+	if (size <= 0 || offset + size > 0xFFFF)
+		return;
+	if ((flags & 0x2000) == 0) // Last fragment
+		fragments.totalLength = offset + size;
+	if (fragments.payload.size() < offset + size)
+		fragments.payload.resize(offset + size);
+	memcpy(fragments.payload.data() + offset, pPayload, size);
+	fragments.ranges.push_back(std::make_pair(offset, size));
+	if (fragments.totalLength < 0)
+		return;
+
+	std::sort(fragments.ranges.begin(), fragments.ranges.end());
+	int covered = 0;
+	for (const std::pair<int, int> & range : fragments.ranges) {
+		if (range.first > covered)
+			return;	// Gap, fragments missing
+		covered = std::max(covered, range.first + range.second);
+		}
+	if (covered < fragments.totalLength)
+		return;
+	const QByteArray payload = fragments.payload.left(fragments.totalLength);
+	m_Fragments.erase(key);
+	m_ReassembledDatagrams++;
+	addDatagram(time, payload.constData(), payload.size());
+}
+
+// -----------------------------------------------------------------------
+// Takes the RTP packet of a UDP datagram (header and payload)
+void CRecordedStream::addDatagram(int64_t time, const char * pData, int size) {
+	if (size < 8)
+		return;
+	const int destinationPort = get16be(pData + 2);
+	const int udpLength       = get16be(pData + 4) - 8;
+	if (m_Port != 0 && destinationPort != m_Port)
+		return;
+	addPacket(time, pData + 8, (udpLength < size - 8) ? udpLength : size - 8);
+}
+
+// -----------------------------------------------------------------------
+void CRecordedStream::addPacket(int64_t time, const char * pData, int size) {
+	if (size < 12 || ((uint8_t)pData[0] >> 6) != 2) // RTP version 2
+		return;
+	if (m_FirstTime < 0)
+		m_FirstTime = time;
+	if ((uint8_t)pData[1] & 0x80)
+		m_Frames++;
+	m_Packets.push_back(CPacket((time > m_FirstTime) ? time - m_FirstTime : 0, QByteArray(pData, size)));
+}
+
+}}} // End namespaces
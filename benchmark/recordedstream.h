@@ -0,0 +1,111 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_BENCHMARK_RECORDEDSTREAM_H
+#define DE_BSWALZ_OLYCAMERARC_BENCHMARK_RECORDEDSTREAM_H
+
+/**
+ * OlympusCamera-RemoteControl: recorded LiveView streams (pcap, rtpdump)
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include <QByteArray>
+#include <QString>
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CRecordedStream
+// RTP packets of a recorded LiveView stream with their arrival times, to
+// be replayed into CRTPDatagramHandler. Formats:
+// - pcap (tcpdump) and pcapng (Wireshark), link types Ethernet, Linux
+//   cooked (SLL, SLL2), BSD loopback and raw IP; UDP over IPv4 or IPv6.
+//   IPv4 fragments are reassembled, IPv6 fragments and the fragments of
+//   incomplete datagrams are skipped and counted
+// - rtpdump ("#!rtpplay1.0", rtptools)
+// Only RTP packets (version 2) are taken, in the order of the file.
+// -----------------------------------------------------------------------
+class CRecordedStream {
+public:
+	class CPacket {
+	public:
+		CPacket(int64_t t = 0, const QByteArray & d = QByteArray()) : time(t), data(d) {}
+		int64_t		time;	// ns since the first packet
+		QByteArray	data;	// RTP header and payload
+	};
+
+	CRecordedStream() : m_Port(0), m_Frames(0), m_FirstTime(-1), m_ReassembledDatagrams(0), m_SkippedFragments(0) {}
+
+	/** port: UDP destination port of the packets to take (pcap), 0: all */
+	bool	load(const QString & fileName, int port = 0);
+	const std::vector<CPacket> & getPackets() const { return m_Packets; }
+	/** Packets with the RTP marker bit, i.e. frames sent by the camera */
+	int		getFrames() const { return m_Frames; }
+	/** Time of the last packet in ns */
+	int64_t	getDuration() const { return m_Packets.empty() ? 0 : m_Packets.back().time; }
+	/** IPv4 datagrams reassembled from fragments */
+	int		getReassembledDatagrams() const { return m_ReassembledDatagrams; }
+	/** IP fragments skipped: IPv6 and incomplete datagrams */
+	int		getSkippedFragments() const { return m_SkippedFragments; }
+	const QString & getFormat() const { return m_Format; }
+	/** Reason of a failed load() resp. warning of a successful one, e.g. skipped fragments */
+	const QString & getError() const { return m_Error; }
+
+private:
+	// Fragments of an IPv4 datagram, key: source, destination, protocol and identification
+	class CFragments {
+	public:
+		CFragments() : totalLength(-1), count(0) {}
+		QByteArray	payload;	// IP payload, the fragments at their offsets
+		std::vector<std::pair<int, int>> ranges;	// Offset and length of the fragments
+		int			totalLength;	// Of the payload, -1: last fragment not yet seen
+		int			count;
+	};
+	typedef std::pair<uint64_t, uint32_t> FragmentKey;
+
+	bool	loadPcap(const QByteArray &);
+	bool	loadPcapNg(const QByteArray &);
+	bool	loadRtpDump(const QByteArray &);
+	void	addFrame(int linkType, int64_t time, const char * pData, int size);
+	void	addFragment(int64_t time, const char * pHeader, const char * pPayload, int size);
+	void	addDatagram(int64_t time, const char * pData, int size);
+	void	addPacket(int64_t time, const char * pData, int size);
+
+	int						m_Port;
+	int						m_Frames;
+	int64_t					m_FirstTime;
+	std::vector<CPacket>	m_Packets;
+	std::map<FragmentKey, CFragments>	m_Fragments;
+	int						m_ReassembledDatagrams;
+	int						m_SkippedFragments;
+	QString					m_Format;
+	QString					m_Error;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_BENCHMARK_RECORDEDSTREAM_H
@@ -0,0 +1,109 @@
+/**
+ * OlympusCamera-RemoteControl: properties of the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "cameraproperties.h"
+#include "xmlpullparser.h"
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CCameraPropertyTable
+// -----------------------------------------------------------------------
+int CCameraPropertyTable::parse(const char * pReply, size_t size) {
+	CXmlPullParser parser(pReply, size);
+	int count = 0;
+	while (parser.next() != CXmlPullParser::EXE_EndDocument) {
+		if (parser.getEvent() == CXmlPullParser::EXE_Error)
+			break;
+		if (parser.getEvent() != CXmlPullParser::EXE_StartElement || !parser.getName().equals("desc"))
+			continue;
+
+		// Children of <desc>, in any order
+		const int depth = parser.getDepth();
+		CXmlText name, attribute, value, enumeration;
+		bool     hasValue = false, hasEnumeration = false;
+		while (parser.next() == CXmlPullParser::EXE_StartElement || parser.getEvent() == CXmlPullParser::EXE_Text) {
+			if (parser.getEvent() == CXmlPullParser::EXE_Text)
+				continue;
+			const CXmlText tag = parser.getName();
+			if      (tag.equals("propname"))	parser.readElementText(name);
+			else if (tag.equals("attribute"))	parser.readElementText(attribute);
+			else if (tag.equals("value"))		hasValue = parser.readElementText(value);
+			else if (tag.equals("enum"))		hasEnumeration = parser.readElementText(enumeration);
+			else								parser.skipElement();
+			}
+		if (parser.getEvent() != CXmlPullParser::EXE_EndElement || parser.getDepth() != depth - 1)
+			break; // Truncated
+		if (name.isEmpty())
+			continue;
+
+		// Strings are assigned in place, a refresh of known properties allocates nothing
+		m_Key.assign(name.data, name.size);
+		CCameraProperty & property = m_Properties[m_Key];
+		if (property.name.empty())
+			property.name = m_Key;
+		if      (attribute.equals("getset"))	property.access = CCameraProperty::ECPA_GetSet;
+		else if (attribute.equals("get"))		property.access = CCameraProperty::ECPA_Get;
+		else if (attribute.equals("set"))		property.access = CCameraProperty::ECPA_Set;
+		else									property.access = CCameraProperty::ECPA_None;
+		if (hasValue)
+			property.value.assign(value.data, value.size);
+
+		// Enumeration: space separated values
+		size_t enumCount = 0;
+		if (hasEnumeration) {
+			const char * p   = enumeration.data;
+			const char * end = enumeration.data + enumeration.size;
+			while (p < end) {
+				while (p < end && *p == ' ') p++;
+				const char * first = p;
+				while (p < end && *p != ' ') p++;
+				if (p == first)
+					continue;
+				if (enumCount < property.enumValues.size())
+					property.enumValues[enumCount].assign(first, p - first);
+				else
+					property.enumValues.push_back(std::string(first, p - first));
+				enumCount++;
+				}
+			}
+		property.enumValues.resize(enumCount);
+		count++;
+		}
+	return count;
+}
+
+// -----------------------------------------------------------------------
+const CCameraProperty * CCameraPropertyTable::find(const std::string & name) const {
+	auto it = m_Properties.find(name);
+	return (it != m_Properties.end()) ? &it->second : nullptr;
+}
+
+}}} // End namespaces
@@ -0,0 +1,80 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_CAMERAPROPERTIES_H
+#define DE_BSWALZ_OLYCAMERARC_CAMERAPROPERTIES_H
+
+/**
+ * OlympusCamera-RemoteControl: properties of the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CCameraProperty
+// A property as described by get_camprop.cgi?com=desc
+// -----------------------------------------------------------------------
+class CCameraProperty {
+public:
+	enum EAccess { ECPA_None = 0, ECPA_Get = 1, ECPA_Set = 2, ECPA_GetSet = 3 };
+
+	CCameraProperty() : access(ECPA_None) {}
+	bool		isReadable() const { return (access & ECPA_Get) != 0; }
+	bool		isWritable() const { return (access & ECPA_Set) != 0; }
+
+	std::string	name;
+	EAccess		access;
+	std::string	value;
+	std::vector<std::string> enumValues;	// Possible values, if settable
+};
+
+// -----------------------------------------------------------------------
+// Class CCameraPropertyTable
+// Properties of the camera by name, filled from the replies of
+// get_camprop.cgi?com=desc, either of a single property (<desc>) or of
+// all properties at once (propname=desclist, <desclist>). The reply is
+// parsed in place by CXmlPullParser.
+// -----------------------------------------------------------------------
+class CCameraPropertyTable {
+public:
+	/** Parses all <desc> elements of the reply, returns their number */
+	int		parse(const char * pReply, size_t size);
+	int		parse(const std::string & reply) { return parse(reply.data(), reply.size()); }
+	/** Returns the property or nullptr if unknown */
+	const CCameraProperty * find(const std::string & name) const;
+	size_t	size() const { return m_Properties.size(); }
+	void	clear() { m_Properties.clear(); }
+private:
+	std::map<std::string, CCameraProperty> m_Properties;
+	std::string	m_Key;	// Reused for the lookup
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_CAMERAPROPERTIES_H
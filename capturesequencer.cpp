@@ -0,0 +1,174 @@
+/**
+ * OlympusCamera-RemoteControl: scheduled capture sequences
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "capturesequencer.h"
+#include "tracing.h"
+#include <QTimer>
+#include <stdio.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CCaptureSequencer
+// -----------------------------------------------------------------------
+CCaptureSequencer::CCaptureSequencer(QObject * pParent)
+	: QObject(pParent), m_pTimer(new QTimer(this)), m_Running(false), m_Stopping(false), m_ShotInFlight(false),
+	  m_ShotPending(false), m_ShotsTriggered(0), m_ShotsSent(0), m_LateShots(0), m_NextTargetTime(0),
+	  m_ShotTargetTime(0), m_FirstSendTime(0), m_LastSendTime(0) {
+	m_pTimer->setSingleShot(true);
+	m_pTimer->setTimerType(Qt::PreciseTimer);
+	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(timerExpired()));
+}
+
+// -----------------------------------------------------------------------
+CCaptureSequencer::~CCaptureSequencer() {
+	// Intentionally left blank
+}
+
+// -----------------------------------------------------------------------
+void CCaptureSequencer::start(const CCaptureSettings & settings) {
+	m_Settings       = settings;
+	m_Running        = m_Settings.shots > 0;
+	m_Stopping       = false;
+	m_ShotInFlight   = false;
+	m_ShotPending    = false;
+	m_ShotsTriggered = 0;
+	m_ShotsSent      = 0;
+	m_LateShots      = 0;
+	m_FirstSendTime  = 0;
+	m_LastSendTime   = 0;
+	m_Jitter.reset();
+	m_Intervals.reset();
+	if (m_Settings.interval < 0)
+		m_Settings.interval = 0;
+	m_NextTargetTime = CLatencyClock::now() + (int64_t)PREPARE_LEAD * 1000000LL;
+	if (m_Running)
+		m_pTimer->start(0); // The caller finishes its state change first
+	else
+		emit finished(); // Nothing to shoot, the caller leaves the sequence state again
+}
+
+// -----------------------------------------------------------------------
+void CCaptureSequencer::stop() {
+	if (!m_Running) {
+		emit finished(); // Leaves the sequence state in any case
+		return;
+		}
+	m_Stopping = true;
+	m_pTimer->stop();
+	if (!m_ShotInFlight) {
+		m_Running = false;
+		emit finished();
+		}
+}
+
+// -----------------------------------------------------------------------
+void CCaptureSequencer::abort() {
+	m_pTimer->stop();
+	m_Running      = false;
+	m_ShotInFlight = false;
+	m_ShotPending  = false;
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: the next shot is due
+void CCaptureSequencer::timerExpired() {
+	if (!m_Running || m_Stopping)
+		return;
+	if (m_ShotInFlight)
+		m_ShotPending = true; // Triggered by shotCompleted()
+	else
+		triggerShot();
+}
+
+// -----------------------------------------------------------------------
+void CCaptureSequencer::triggerShot() {
+	if (m_ShotPending)
+		m_LateShots++;
+	m_ShotInFlight   = true;
+	m_ShotPending    = false;
+	m_ShotTargetTime = m_NextTargetTime;
+	m_ShotsTriggered++;
+	OLYCAMERARC_TRACE_INSTANT("Capture shot due");
+
+	if (m_Settings.interval > 0 && m_ShotsTriggered < m_Settings.shots) {
+		m_NextTargetTime += (int64_t)m_Settings.interval * 1000000LL;
+		const int64_t remaining = m_NextTargetTime - (int64_t)PREPARE_LEAD * 1000000LL - CLatencyClock::now();
+		m_pTimer->start(remaining > 0 ? (int)(remaining / 1000000LL) : 0);
+		}
+	emit shotDue(m_ShotTargetTime);
+}
+
+// -----------------------------------------------------------------------
+void CCaptureSequencer::shotSent(int64_t sendTime) {
+	if (!m_Running)
+		return;
+	const int64_t deviation = sendTime - m_ShotTargetTime;
+	m_Jitter.add(deviation >= 0 ? deviation : -deviation);
+	if (m_ShotsSent == 0)
+		m_FirstSendTime = sendTime;
+	else
+		m_Intervals.add(sendTime - m_LastSendTime);
+	m_LastSendTime = sendTime;
+	m_ShotsSent++;
+}
+
+// -----------------------------------------------------------------------
+void CCaptureSequencer::shotCompleted() {
+	if (!m_Running || !m_ShotInFlight)
+		return;
+	m_ShotInFlight = false;
+	if (m_Stopping || m_ShotsTriggered >= m_Settings.shots) {
+		m_pTimer->stop();
+		m_Running = false;
+		emit finished();
+		}
+	else if (m_Settings.interval == 0) { // As fast as possible
+		m_NextTargetTime = CLatencyClock::now();
+		triggerShot();
+		}
+	else if (m_ShotPending) {
+		triggerShot();
+		}
+}
+
+// -----------------------------------------------------------------------
+std::string CCaptureSequencer::getSummary() const {
+	const double achieved = (m_ShotsSent > 1) ? (m_LastSendTime - m_FirstSendTime) / 1e6 / (m_ShotsSent - 1) : 0.0;
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+			 "Capture sequence: %d/%d shots, interval requested %d ms, achieved %.1f ms (max %.1f ms), "
+			 "jitter p50 %.1f ms, p95 %.1f ms, max %.1f ms, %d late",
+			 m_ShotsSent, m_Settings.shots, m_Settings.interval, achieved, m_Intervals.getMax() / 1e6,
+			 m_Jitter.getPercentile(50.0) / 1e6, m_Jitter.getPercentile(95.0) / 1e6, m_Jitter.getMax() / 1e6, m_LateShots);
+	return std::string(buffer);
+}
+
+}}} // End namespaces
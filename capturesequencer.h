@@ -0,0 +1,115 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_CAPTURESEQUENCER_H
+#define DE_BSWALZ_OLYCAMERARC_CAPTURESEQUENCER_H
+
+/**
+ * OlympusCamera-RemoteControl: scheduled capture sequences
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "latencystatistics.h"
+#include <QObject>
+#include <string>
+#include <stdint.h>
+
+class QTimer;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CCaptureSettings
+// -----------------------------------------------------------------------
+class CCaptureSettings {
+public:
+	CCaptureSettings() : shots(10), interval(1000) {}
+	int		shots;
+	int		interval;	// ms between the trigger commands, 0: as fast as possible
+};
+
+// -----------------------------------------------------------------------
+// Class CCaptureSequencer
+// Schedules the shots of a capture sequence on a fixed time grid (start
+// time + n * interval, no drift) and measures the send times of the
+// trigger commands against it. Each shot is announced PREPARE_LEAD ahead
+// of its target time, so that the sender can free the connection to the
+// camera. A shot which is due while the previous one is still in flight
+// is triggered as soon as that one has completed.
+// -----------------------------------------------------------------------
+class CCaptureSequencer : public QObject {
+	Q_OBJECT
+public:
+	static const int PREPARE_LEAD = 150;	// ms
+
+	CCaptureSequencer(QObject * pParent = nullptr);
+	virtual ~CCaptureSequencer();
+
+	/** Starts a sequence, the first shot is due immediately. Without shots finished() follows. */
+	void	start(const CCaptureSettings &);
+	/** No further shots, finished() follows the shot in flight resp. at once if none is running */
+	void	stop();
+	/** Stops immediately without finished(), e.g. on errors */
+	void	abort();
+	/** True from start() until finished() resp. abort() */
+	bool	isRunning() const { return m_Running; }
+	/** The trigger command of the current shot has been sent */
+	void	shotSent(int64_t sendTime);
+	/** The release command of the current shot has been processed */
+	void	shotCompleted();
+	/** Shots, requested vs. achieved interval and jitter of the send times */
+	std::string	getSummary() const;
+
+signals:
+	/** The trigger command of the next shot has to be sent at targetTime (CLatencyClock) */
+	void	shotDue(qint64 targetTime);
+	void	finished();
+
+protected slots:
+	void	timerExpired();
+
+private:
+	void	triggerShot();
+
+	CCaptureSettings	m_Settings;
+	QTimer *			m_pTimer;
+	bool				m_Running;
+	bool				m_Stopping;
+	bool				m_ShotInFlight;
+	bool				m_ShotPending;		// Due, but the previous shot is still in flight
+	int					m_ShotsTriggered;
+	int					m_ShotsSent;
+	int					m_LateShots;
+	int64_t				m_NextTargetTime;	// CLatencyClock
+	int64_t				m_ShotTargetTime;	// of the shot in flight
+	int64_t				m_FirstSendTime;
+	int64_t				m_LastSendTime;
+	CLatencyHistogram	m_Jitter;			// |send time - target time|
+	CLatencyHistogram	m_Intervals;		// Between the send times
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_CAPTURESEQUENCER_H
@@ -0,0 +1,158 @@
+/**
+ * OlympusCamera-RemoteControl: command list of the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "commandlist.h"
+#include "xmlpullparser.h"
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CCommandNode
+// -----------------------------------------------------------------------
+const CCommandNode * CCommandNode::findChild(EType childType, const char * childName) const {
+	for (const CCommandNode & child : children) {
+		if (child.type == childType && child.name == childName)
+			return &child;
+		}
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------
+// Class CCommandList
+// -----------------------------------------------------------------------
+void CCommandList::clear() {
+	m_Version.clear();
+	m_Functions.clear();
+	m_Cgis.clear();
+}
+
+// -----------------------------------------------------------------------
+// <cmdN>/<paramN> are recognized by their prefix, the level N follows from
+// the nesting. The path holds the open nodes below the current CGI.
+int CCommandList::parse(const char * pReply, size_t size) {
+	clear();
+	CXmlPullParser parser(pReply, size);
+	std::vector<CCommandNode*> path;
+	CXmlText name, text;
+	while (parser.next() != CXmlPullParser::EXE_EndDocument) {
+		switch (parser.getEvent()) {
+			case CXmlPullParser::EXE_Error:
+					clear();
+					return -1;
+			case CXmlPullParser::EXE_StartElement: {
+					const CXmlText & tag = parser.getName();
+					if (parser.getDepth() == 1) {
+						if (!tag.equals("oishare")) {
+							clear();
+							return -1;
+							}
+						}
+					else if (parser.getDepth() == 2 && tag.equals("version")) {
+						if (parser.readElementText(text))
+							m_Version = text.toString();
+						}
+					else if (parser.getDepth() == 2 && tag.equals("support")) {
+						if (parser.getAttribute("func", name))
+							m_Functions.push_back(name.toString());
+						}
+					else if (parser.getDepth() == 2 && tag.equals("cgi")) {
+						m_Cgis.push_back(CCommandNode(CCommandNode::ECN_Cgi));
+						if (parser.getAttribute("name", name))
+							m_Cgis.back().name = name.toString();
+						path.assign(1, &m_Cgis.back());
+						}
+					else if (path.size() == 1 && parser.getDepth() == 3 && tag.equals("http_method")) {
+						if (parser.getAttribute("type", name)) {
+							std::string & methods = path.back()->methods;
+							if (!methods.empty()) methods += ' ';
+							methods.append(name.data, name.size);
+							}
+						}
+					else if (!path.empty() && parser.getDepth() == (int)path.size() + 3 &&
+							 (tag.startsWith("cmd") || tag.startsWith("param"))) {
+						const CCommandNode::EType type = (tag.data[0] == 'c') ? CCommandNode::ECN_Command : CCommandNode::ECN_Parameter;
+						std::vector<CCommandNode> & children = path.back()->children;
+						children.push_back(CCommandNode(type));
+						if (parser.getAttribute("name", name))
+							children.back().name = name.toString();
+						path.push_back(&children.back());	// Stable until the node is closed
+						}
+					else if (parser.getDepth() > 2) {
+						parser.skipElement();	// Unknown element
+						}
+					} break;
+			case CXmlPullParser::EXE_EndElement:
+					if (path.size() > 1 && parser.getDepth() == (int)path.size() + 1)
+						path.pop_back();	// </cmdN> resp. </paramN>
+					else if (parser.getDepth() == 1)
+						path.clear();		// </cgi>
+					break;
+			default:	break;
+			}
+		}
+	return (int)m_Cgis.size();
+}
+
+// -----------------------------------------------------------------------
+bool CCommandList::supports(const char * function) const {
+	for (const std::string & f : m_Functions) {
+		if (f == function)
+			return true;
+		}
+	return false;
+}
+
+// -----------------------------------------------------------------------
+const CCommandNode * CCommandList::findCgi(const char * cgi) const {
+	for (const CCommandNode & node : m_Cgis) {
+		if (node.name == cgi)
+			return &node;
+		}
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------
+bool CCommandList::hasParameter(const char * cgi, const char * command, const char * parameter) const {
+	const CCommandNode * pCgi = findCgi(cgi);
+	return pCgi != nullptr && hasParameter(*pCgi, command, parameter);
+}
+
+// -----------------------------------------------------------------------
+bool CCommandList::hasParameter(const CCommandNode & node, const char * command, const char * parameter) {
+	if (node.type == CCommandNode::ECN_Command && node.name == command && node.findChild(CCommandNode::ECN_Parameter, parameter) != nullptr)
+		return true;
+	for (const CCommandNode & child : node.children) {
+		if (hasParameter(child, command, parameter))
+			return true;
+		}
+	return false;
+}
+
+}}} // End namespaces
@@ -0,0 +1,91 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_COMMANDLIST_H
+#define DE_BSWALZ_OLYCAMERARC_COMMANDLIST_H
+
+/**
+ * OlympusCamera-RemoteControl: command list of the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CCommandNode
+// Node of the command tree of get_commandlist.cgi: a CGI has commands
+// (<cmd1 name="com">), a command has parameters (<param1 name="desc">) and
+// may have subcommands, a parameter may have commands of the next level
+// (<cmd2 name="propname">), and so on.
+// -----------------------------------------------------------------------
+class CCommandNode {
+public:
+	enum EType { ECN_Cgi, ECN_Command, ECN_Parameter };
+
+	CCommandNode(EType t = ECN_Cgi) : type(t) {}
+	/** Child of the type and name, nullptr if there is none */
+	const CCommandNode * findChild(EType type, const char * name) const;
+
+	EType		type;
+	std::string	name;					// Empty for a parameter without a name (e.g. <param1> of DIR)
+	std::string	methods;				// CGI only: "get", "post" resp. "get post"
+	std::vector<CCommandNode> children;
+};
+
+// -----------------------------------------------------------------------
+// Class CCommandList
+// The reply of get_commandlist.cgi, parsed in place by CXmlPullParser
+// -----------------------------------------------------------------------
+class CCommandList {
+public:
+	/** Replaces the list, returns the number of CGIs or -1 if the reply is invalid */
+	int		parse(const char * pReply, size_t size);
+	void	clear();
+
+	const std::string &	getVersion() const { return m_Version; }
+	/** <support func="..."/> */
+	bool	supports(const char * function) const;
+	/** Returns the CGI or nullptr if the camera doesn't know it */
+	const CCommandNode * findCgi(const char * cgi) const;
+	/** Whether the command of the CGI (at any level) has the parameter,
+	 *  e.g. hasParameter("get_camprop", "propname", "desclist") */
+	bool	hasParameter(const char * cgi, const char * command, const char * parameter) const;
+	const std::vector<CCommandNode> & getCgis() const { return m_Cgis; }
+
+private:
+	static bool hasParameter(const CCommandNode & node, const char * command, const char * parameter);
+
+	std::string					m_Version;
+	std::vector<std::string>	m_Functions;
+	std::vector<CCommandNode>	m_Cgis;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_COMMANDLIST_H
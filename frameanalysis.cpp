@@ -0,0 +1,392 @@
+/**
+ * OlympusCamera-RemoteControl: focus peaking and histogram of LiveView images
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "frameanalysis.h"
+#include "tracing.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <string.h>
+#include <vector>
+#if defined(OLYCAMERARC_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(OLYCAMERARC_AVX2)
+#include <immintrin.h>
+#endif
+#if defined(OLYCAMERARC_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+// Luminance (BT.601): (29 B + 150 G + 77 R) / 256, the weights sum up to 256
+const int WEIGHT_B = 29;
+const int WEIGHT_G = 150;
+const int WEIGHT_R = 77;
+
+// -----------------------------------------------------------------------
+// Scalar kernels, also for the remainder of a row
+// -----------------------------------------------------------------------
+void computeLumaScalar(const uint8_t * pPixels, uint8_t * pLuma, int x, int width) {
+	for (; x < width; x++) {
+		const uint8_t * p = pPixels + 4 * x;
+		pLuma[x] = (uint8_t)((WEIGHT_B * p[0] + WEIGHT_G * p[1] + WEIGHT_R * p[2]) >> 8);
+		}
+}
+
+// -----------------------------------------------------------------------
+// x from 1 up to width - 2, the border pixels are never marked
+void markEdgesScalar(const uint8_t * pAbove, const uint8_t * pLuma, const uint8_t * pBelow,
+					 uint8_t * pPixels, int x, int width, int threshold, uint32_t color) {
+	for (; x < width - 1; x++) {
+		const int dx = pLuma[x + 1] - pLuma[x - 1];
+		const int dy = pBelow[x] - pAbove[x];
+		const int magnitude = (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+		if (magnitude > threshold)
+			memcpy(pPixels + 4 * x, &color, 4);
+		}
+}
+
+#if defined(OLYCAMERARC_SSE2)
+// -----------------------------------------------------------------------
+// SSE2: 16 pixels per iteration. B and R resp. G and A are multiplied by
+// their weights as 16 bit values and added pairwise (pmaddwd).
+// -----------------------------------------------------------------------
+int computeLumaSSE2(const uint8_t * pPixels, uint8_t * pLuma, int width) {
+	const __m128i mask      = _mm_set1_epi32(0x00FF00FF);
+	const __m128i weightsBR = _mm_set1_epi32((WEIGHT_R << 16) | WEIGHT_B);
+	const __m128i weightsGA = _mm_set1_epi32(WEIGHT_G);
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i sums[4];
+		for (int i = 0; i < 4; i++) {
+			const __m128i pixels = _mm_loadu_si128((const __m128i*)(pPixels + 4 * (x + 4 * i)));
+			const __m128i br     = _mm_and_si128(pixels, mask);
+			const __m128i ga     = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+			sums[i] = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(br, weightsBR), _mm_madd_epi16(ga, weightsGA)), 8);
+			}
+		const __m128i low  = _mm_packs_epi32(sums[0], sums[1]);
+		const __m128i high = _mm_packs_epi32(sums[2], sums[3]);
+		_mm_storeu_si128((__m128i*)(pLuma + x), _mm_packus_epi16(low, high));
+		}
+	return x;
+}
+
+// -----------------------------------------------------------------------
+// SSE2: 16 pixels per iteration, rows without edges are skipped quickly
+int markEdgesSSE2(const uint8_t * pAbove, const uint8_t * pLuma, const uint8_t * pBelow,
+				  uint8_t * pPixels, int width, int threshold, uint32_t color) {
+	const __m128i limit  = _mm_set1_epi8((char)(threshold + 1));
+	const __m128i colors = _mm_set1_epi32((int)color);
+	int x = 1;
+	for (; x + 17 <= width; x += 16) {
+		const __m128i left  = _mm_loadu_si128((const __m128i*)(pLuma + x - 1));
+		const __m128i right = _mm_loadu_si128((const __m128i*)(pLuma + x + 1));
+		const __m128i above = _mm_loadu_si128((const __m128i*)(pAbove + x));
+		const __m128i below = _mm_loadu_si128((const __m128i*)(pBelow + x));
+		const __m128i dx    = _mm_or_si128(_mm_subs_epu8(right, left), _mm_subs_epu8(left, right));
+		const __m128i dy    = _mm_or_si128(_mm_subs_epu8(below, above), _mm_subs_epu8(above, below));
+		const __m128i magnitude = _mm_adds_epu8(dx, dy);
+		const __m128i edges = _mm_cmpeq_epi8(_mm_max_epu8(magnitude, limit), magnitude);	// magnitude > threshold
+		if (_mm_movemask_epi8(edges) == 0)
+			continue;
+		const __m128i edges16[2] = { _mm_unpacklo_epi8(edges, edges), _mm_unpackhi_epi8(edges, edges) };
+		for (int i = 0; i < 4; i++) {
+			const __m128i mask   = (i & 1) ? _mm_unpackhi_epi16(edges16[i / 2], edges16[i / 2]) : _mm_unpacklo_epi16(edges16[i / 2], edges16[i / 2]);
+			__m128i *     p      = (__m128i*)(pPixels + 4 * (x + 4 * i));
+			const __m128i pixels = _mm_loadu_si128(p);
+			_mm_storeu_si128(p, _mm_or_si128(_mm_andnot_si128(mask, pixels), _mm_and_si128(mask, colors)));
+			}
+		}
+	return x;
+}
+#endif
+
+#if defined(OLYCAMERARC_AVX2)
+// -----------------------------------------------------------------------
+// AVX2: 32 pixels per iteration. pack* works per 128 bit lane, the
+// result is put in order by a permutation of the 32 bit elements.
+// -----------------------------------------------------------------------
+__attribute__((target("avx2")))
+int computeLumaAVX2(const uint8_t * pPixels, uint8_t * pLuma, int width) {
+	const __m256i mask      = _mm256_set1_epi32(0x00FF00FF);
+	const __m256i weightsBR = _mm256_set1_epi32((WEIGHT_R << 16) | WEIGHT_B);
+	const __m256i weightsGA = _mm256_set1_epi32(WEIGHT_G);
+	const __m256i order     = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int x = 0;
+	for (; x + 32 <= width; x += 32) {
+		__m256i sums[4];
+		for (int i = 0; i < 4; i++) {
+			const __m256i pixels = _mm256_loadu_si256((const __m256i*)(pPixels + 4 * (x + 8 * i)));
+			const __m256i br     = _mm256_and_si256(pixels, mask);
+			const __m256i ga     = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), mask);
+			sums[i] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(br, weightsBR), _mm256_madd_epi16(ga, weightsGA)), 8);
+			}
+		const __m256i low  = _mm256_packs_epi32(sums[0], sums[1]);
+		const __m256i high = _mm256_packs_epi32(sums[2], sums[3]);
+		_mm256_storeu_si256((__m256i*)(pLuma + x), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order));
+		}
+	return x;
+}
+
+// -----------------------------------------------------------------------
+// AVX2: 32 pixels per iteration, the byte mask is sign extended per pixel
+__attribute__((target("avx2")))
+int markEdgesAVX2(const uint8_t * pAbove, const uint8_t * pLuma, const uint8_t * pBelow,
+				  uint8_t * pPixels, int width, int threshold, uint32_t color) {
+	const __m256i limit  = _mm256_set1_epi8((char)(threshold + 1));
+	const __m256i colors = _mm256_set1_epi32((int)color);
+	int x = 1;
+	for (; x + 33 <= width; x += 32) {
+		const __m256i left  = _mm256_loadu_si256((const __m256i*)(pLuma + x - 1));
+		const __m256i right = _mm256_loadu_si256((const __m256i*)(pLuma + x + 1));
+		const __m256i above = _mm256_loadu_si256((const __m256i*)(pAbove + x));
+		const __m256i below = _mm256_loadu_si256((const __m256i*)(pBelow + x));
+		const __m256i dx    = _mm256_or_si256(_mm256_subs_epu8(right, left), _mm256_subs_epu8(left, right));
+		const __m256i dy    = _mm256_or_si256(_mm256_subs_epu8(below, above), _mm256_subs_epu8(above, below));
+		const __m256i magnitude = _mm256_adds_epu8(dx, dy);
+		const __m256i edges = _mm256_cmpeq_epi8(_mm256_max_epu8(magnitude, limit), magnitude);
+		if (_mm256_movemask_epi8(edges) == 0)
+			continue;
+		for (int i = 0; i < 4; i++) {
+			const __m128i half   = (i < 2) ? _mm256_castsi256_si128(edges) : _mm256_extracti128_si256(edges, 1);
+			const __m256i mask   = _mm256_cvtepi8_epi32((i & 1) ? _mm_srli_si128(half, 8) : half);
+			__m256i *     p      = (__m256i*)(pPixels + 4 * (x + 8 * i));
+			_mm256_storeu_si256(p, _mm256_blendv_epi8(_mm256_loadu_si256(p), colors, mask));
+			}
+		}
+	return x;
+}
+
+bool hasAVX2() {
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	return avx2;
+}
+#endif
+
+#if defined(OLYCAMERARC_NEON)
+// -----------------------------------------------------------------------
+// NEON: 16 pixels per iteration, loaded deinterleaved by channel
+// -----------------------------------------------------------------------
+int computeLumaNEON(const uint8_t * pPixels, uint8_t * pLuma, int width) {
+	const uint8x8_t weightB = vdup_n_u8(WEIGHT_B);
+	const uint8x8_t weightG = vdup_n_u8(WEIGHT_G);
+	const uint8x8_t weightR = vdup_n_u8(WEIGHT_R);
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const uint8x16x4_t pixels = vld4q_u8(pPixels + 4 * x);	// B, G, R, A
+		uint16x8_t low  = vmull_u8(vget_low_u8(pixels.val[0]), weightB);
+		uint16x8_t high = vmull_u8(vget_high_u8(pixels.val[0]), weightB);
+		low  = vmlal_u8(low,  vget_low_u8(pixels.val[1]),  weightG);
+		high = vmlal_u8(high, vget_high_u8(pixels.val[1]), weightG);
+		low  = vmlal_u8(low,  vget_low_u8(pixels.val[2]),  weightR);
+		high = vmlal_u8(high, vget_high_u8(pixels.val[2]), weightR);
+		vst1q_u8(pLuma + x, vcombine_u8(vshrn_n_u16(low, 8), vshrn_n_u16(high, 8)));
+		}
+	return x;
+}
+
+// -----------------------------------------------------------------------
+// NEON: 16 pixels per iteration, the channels are selected by the mask
+int markEdgesNEON(const uint8_t * pAbove, const uint8_t * pLuma, const uint8_t * pBelow,
+				  uint8_t * pPixels, int width, int threshold, uint32_t color) {
+	const uint8x16_t limit = vdupq_n_u8((uint8_t)threshold);
+	const uint8x16_t colorB = vdupq_n_u8((uint8_t)color);
+	const uint8x16_t colorG = vdupq_n_u8((uint8_t)(color >> 8));
+	const uint8x16_t colorR = vdupq_n_u8((uint8_t)(color >> 16));
+	int x = 1;
+	for (; x + 17 <= width; x += 16) {
+		const uint8x16_t dx = vabdq_u8(vld1q_u8(pLuma + x + 1), vld1q_u8(pLuma + x - 1));
+		const uint8x16_t dy = vabdq_u8(vld1q_u8(pBelow + x), vld1q_u8(pAbove + x));
+		const uint8x16_t edges = vcgtq_u8(vqaddq_u8(dx, dy), limit);
+		const uint64x2_t any = vreinterpretq_u64_u8(edges);
+		if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) == 0)
+			continue;
+		uint8x16x4_t pixels = vld4q_u8(pPixels + 4 * x);
+		pixels.val[0] = vbslq_u8(edges, colorB, pixels.val[0]);
+		pixels.val[1] = vbslq_u8(edges, colorG, pixels.val[1]);
+		pixels.val[2] = vbslq_u8(edges, colorR, pixels.val[2]);
+		vst4q_u8(pPixels + 4 * x, pixels);
+		}
+	return x;
+}
+#endif
+
+} // End anonymous namespace
+
+// -----------------------------------------------------------------------
+// Class CFrameHistogram
+// -----------------------------------------------------------------------
+void CFrameHistogram::reset() {
+	memset(luma, 0, sizeof(luma));
+	memset(red, 0, sizeof(red));
+	memset(green, 0, sizeof(green));
+	memset(blue, 0, sizeof(blue));
+}
+
+// -----------------------------------------------------------------------
+uint32_t CFrameHistogram::getMax() const {
+	uint32_t max = 1;
+	for (int i = 0; i < 256; i++) {
+		if (luma[i] > max)	max = luma[i];
+		if (red[i] > max)	max = red[i];
+		if (green[i] > max)	max = green[i];
+		if (blue[i] > max)	max = blue[i];
+		}
+	return max;
+}
+
+// -----------------------------------------------------------------------
+// Class CFrameAnalyzer
+// -----------------------------------------------------------------------
+const char * CFrameAnalyzer::getKernelName() {
+#if defined(OLYCAMERARC_AVX2)
+	if (hasAVX2())
+		return "AVX2";
+#endif
+#if defined(OLYCAMERARC_SSE2)
+	return "SSE2";
+#elif defined(OLYCAMERARC_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+// -----------------------------------------------------------------------
+void CFrameAnalyzer::computeLuma(const uint8_t * pPixels, uint8_t * pLuma, int width) {
+	int x = 0;
+#if defined(OLYCAMERARC_AVX2)
+	if (hasAVX2())
+		x = computeLumaAVX2(pPixels, pLuma, width);
+	else
+#endif
+#if defined(OLYCAMERARC_SSE2)
+	x = computeLumaSSE2(pPixels, pLuma, width);
+#elif defined(OLYCAMERARC_NEON)
+	x = computeLumaNEON(pPixels, pLuma, width);
+#endif
+	computeLumaScalar(pPixels, pLuma, x, width);
+}
+
+// -----------------------------------------------------------------------
+// Marks the pixels of a row whose luminance gradient |dx| + |dy| (central
+// differences) exceeds the threshold (0..254)
+void CFrameAnalyzer::markEdges(const uint8_t * pAbove, const uint8_t * pLuma, const uint8_t * pBelow,
+							   uint8_t * pPixels, int width, int threshold, uint32_t color) {
+	threshold = (threshold < 0) ? 0 : (threshold > 254) ? 254 : threshold;
+	int x = 1;
+#if defined(OLYCAMERARC_AVX2)
+	if (hasAVX2())
+		x = markEdgesAVX2(pAbove, pLuma, pBelow, pPixels, width, threshold, color);
+	else
+#endif
+#if defined(OLYCAMERARC_SSE2)
+	x = markEdgesSSE2(pAbove, pLuma, pBelow, pPixels, width, threshold, color);
+#elif defined(OLYCAMERARC_NEON)
+	x = markEdgesNEON(pAbove, pLuma, pBelow, pPixels, width, threshold, color);
+#endif
+	markEdgesScalar(pAbove, pLuma, pBelow, pPixels, x, width, threshold, color);
+}
+
+// -----------------------------------------------------------------------
+// Scatter increments, scalar on all platforms. The luminance of the row
+// is taken from the SIMD kernel.
+void CFrameAnalyzer::addToHistogram(const uint8_t * pPixels, const uint8_t * pLuma, int width, CFrameHistogram & histogram) {
+	for (int x = 0; x < width; x++) {
+		const uint8_t * p = pPixels + 4 * x;
+		histogram.blue[p[0]]++;
+		histogram.green[p[1]]++;
+		histogram.red[p[2]]++;
+		histogram.luma[pLuma[x]]++;
+		}
+}
+
+// -----------------------------------------------------------------------
+// Semi-transparent box in the lower right corner: luminance filled, RGB as lines
+void CFrameAnalyzer::drawHistogram(QImage & image, const CFrameHistogram & histogram) {
+	const int    width  = qMin(256, image.width() / 3);
+	const int    height = width / 2;
+	const QRectF box(image.width() - width - 6, image.height() - height - 6, width, height);
+	const double scaleX = box.width() / 255.0;
+	const double scaleY = box.height() / histogram.getMax();
+	const uint32_t * channels[] = { histogram.red, histogram.green, histogram.blue };
+	const QColor     colors[]   = { QColor(255, 64, 64), QColor(64, 255, 64), QColor(64, 128, 255) };
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.fillRect(box, QColor(0, 0, 0, 128));
+	QPainterPath luma(box.bottomLeft());
+	for (int i = 0; i < 256; i++)
+		luma.lineTo(box.left() + i * scaleX, box.bottom() - histogram.luma[i] * scaleY);
+	luma.lineTo(box.bottomRight());
+	painter.fillPath(luma, QColor(255, 255, 255, 96));
+	for (int c = 0; c < 3; c++) {
+		QPolygonF line;
+		for (int i = 0; i < 256; i++)
+			line << QPointF(box.left() + i * scaleX, box.bottom() - channels[c][i] * scaleY);
+		painter.setPen(QPen(colors[c], 1.0));
+		painter.drawPolyline(line);
+		}
+}
+
+// -----------------------------------------------------------------------
+// One pass over the rows: the luminance of row y + 1 is computed before
+// row y is marked, the histogram is taken before marking
+void CFrameAnalyzer::analyze(QImage & image) const {
+	if (!isEnabled() || image.isNull())
+		return;
+	OLYCAMERARC_TRACE_SCOPE("LiveView analysis");
+	if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+		image = image.convertToFormat(QImage::Format_RGB32);
+	const int width  = image.width();
+	const int height = image.height();
+	thread_local std::vector<uint8_t> lumaRows;	// Allocated once per worker thread
+	if (lumaRows.size() < (size_t)(3 * width))
+		lumaRows.resize(3 * width);
+	uint8_t * rows[3] = { &lumaRows[0], &lumaRows[width], &lumaRows[2 * width] };
+	CFrameHistogram histogram;
+
+	computeLuma(image.constScanLine(0), rows[0], width);
+	for (int y = 0; y < height; y++) {
+		uint8_t * pLine = image.scanLine(y);
+		if (y + 1 < height)
+			computeLuma(image.constScanLine(y + 1), rows[(y + 1) % 3], width);
+		if (m_Histogram)
+			addToHistogram(pLine, rows[y % 3], width, histogram);
+		if (m_FocusPeaking && y > 0 && y + 1 < height)
+			markEdges(rows[(y + 2) % 3], rows[y % 3], rows[(y + 1) % 3], pLine, width, m_PeakingThreshold, PEAKING_COLOR);
+		}
+	if (m_Histogram)
+		drawHistogram(image, histogram);
+}
+
+}}} // End namespaces
@@ -0,0 +1,112 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_FRAMEANALYSIS_H
+#define DE_BSWALZ_OLYCAMERARC_FRAMEANALYSIS_H
+
+/**
+ * OlympusCamera-RemoteControl: focus peaking and histogram of LiveView images
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include <QImage>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------
+// SIMD kernels: AVX2 (selected at runtime), SSE2, NEON, otherwise scalar.
+// Define OLYCAMERARC_NO_SIMD to use the scalar kernels only.
+// -----------------------------------------------------------------------
+#if !defined(OLYCAMERARC_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64)
+#define OLYCAMERARC_SSE2
+#if defined(__GNUC__)
+#define OLYCAMERARC_AVX2		// Functions with target attribute, used if the CPU has AVX2
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OLYCAMERARC_NEON
+#endif
+#endif
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CFrameHistogram
+// Luminance and RGB histogram of an image
+// -----------------------------------------------------------------------
+class CFrameHistogram {
+public:
+	CFrameHistogram() { reset(); }
+	void		reset();
+	uint32_t	getMax() const;		// Of all channels, for scaling
+	uint32_t	luma[256];
+	uint32_t	red[256];
+	uint32_t	green[256];
+	uint32_t	blue[256];
+};
+
+// -----------------------------------------------------------------------
+// Class CFrameAnalyzer
+// Optional overlays of a decoded LiveView image, computed in place by the
+// decoding worker: focus peaking (pixels with a luminance gradient above
+// the threshold are highlighted) and a luminance/RGB histogram drawn into
+// the lower right corner. The image is processed row by row with a ring
+// of three luminance rows, i.e. in one pass while it is in the cache.
+// Copied into each decode job, so the settings need no synchronisation.
+// -----------------------------------------------------------------------
+class CFrameAnalyzer {
+public:
+	static const int      DEFAULT_PEAKING_THRESHOLD = 48;	// |dx| + |dy| of the luminance, 0..510
+	static const uint32_t PEAKING_COLOR             = 0xFFFF2020;
+
+	CFrameAnalyzer() : m_FocusPeaking(false), m_Histogram(false), m_PeakingThreshold(DEFAULT_PEAKING_THRESHOLD) {}
+
+	void	setFocusPeakingEnabled(bool enabled) { m_FocusPeaking = enabled; }
+	bool	isFocusPeakingEnabled() const { return m_FocusPeaking; }
+	void	setHistogramEnabled(bool enabled) { m_Histogram = enabled; }
+	bool	isHistogramEnabled() const { return m_Histogram; }
+	void	setPeakingThreshold(int threshold) { m_PeakingThreshold = threshold; }
+	bool	isEnabled() const { return m_FocusPeaking || m_Histogram; }
+
+	/** Draws the enabled overlays into the image (converted to RGB32 if necessary) */
+	void	analyze(QImage & image) const;
+	/** "AVX2", "SSE2", "NEON" or "scalar" */
+	static const char * getKernelName();
+
+	/** Kernels. Pixels: QImage::Format_RGB32 (B, G, R, A in memory). */
+	static void computeLuma(const uint8_t * pPixels, uint8_t * pLuma, int width);
+	static void markEdges(const uint8_t * pAbove, const uint8_t * pLuma, const uint8_t * pBelow,
+						  uint8_t * pPixels, int width, int threshold, uint32_t color);
+	static void addToHistogram(const uint8_t * pPixels, const uint8_t * pLuma, int width, CFrameHistogram &);
+	static void drawHistogram(QImage &, const CFrameHistogram &);
+
+private:
+	bool	m_FocusPeaking;
+	bool	m_Histogram;
+	int		m_PeakingThreshold;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_FRAMEANALYSIS_H
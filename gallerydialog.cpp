@@ -0,0 +1,193 @@
+/**
+ * OlympusCamera-RemoteControl: gallery of the images on the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "gallerydialog.h"
+#include "imagelibrary.h"
+#include "maincontroller.h"
+#include <QDir>
+#include <QHBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QListWidget>
+#include <QPixmap>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QVBoxLayout>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+const QSize THUMBNAIL_SIZE  = QSize(160, 120);
+const QSize SCREENNAIL_SIZE = QSize(320, 240);
+}
+
+// -----------------------------------------------------------------------
+// Class CGalleryDialog
+// -----------------------------------------------------------------------
+CGalleryDialog::CGalleryDialog(IMainController * pMainController, QWidget * pParent)
+	: QDialog(pParent), m_pMainController(pMainController), m_pImageLibrary(pMainController->getImageLibrary()) {
+	setWindowTitle("Images on the camera");
+
+	m_pImageList = new QListWidget();
+	m_pImageList->setViewMode(QListView::IconMode);
+	m_pImageList->setIconSize(THUMBNAIL_SIZE);
+	m_pImageList->setResizeMode(QListView::Adjust);
+	m_pImageList->setUniformItemSizes(true);
+	m_pImageList->setMovement(QListView::Static);
+	m_pPreviewLabel   = new QLabel();
+	m_pPreviewLabel->setFixedSize(SCREENNAIL_SIZE);
+	m_pPreviewLabel->setAlignment(Qt::AlignCenter);
+	m_pStatusLabel    = new QLabel("Switching to play mode ...");
+	m_pDownloadButton = new QPushButton("Download (2048)");
+	m_pOriginalButton = new QPushButton("Download original");
+	QPushButton * pCloseButton = new QPushButton("Close");
+
+	QHBoxLayout * pButtonLayout = new QHBoxLayout();
+	pButtonLayout->addWidget(m_pStatusLabel, 1);
+	pButtonLayout->addWidget(m_pDownloadButton);
+	pButtonLayout->addWidget(m_pOriginalButton);
+	pButtonLayout->addWidget(pCloseButton);
+	QHBoxLayout * pImageLayout = new QHBoxLayout();
+	pImageLayout->addWidget(m_pImageList, 1);
+	pImageLayout->addWidget(m_pPreviewLabel, 0, Qt::AlignTop);
+	QVBoxLayout * pLayout = new QVBoxLayout(this);
+	pLayout->addItem(pImageLayout);
+	pLayout->addItem(pButtonLayout);
+
+	connect(m_pImageLibrary, SIGNAL(imageListChanged()), this, SLOT(imageListChanged()));
+	connect(m_pImageLibrary, SIGNAL(thumbnailAvailable(int)), this, SLOT(thumbnailAvailable(int)));
+	connect(m_pImageLibrary, SIGNAL(screennailAvailable(int)), this, SLOT(screennailAvailable(int)));
+	connect(m_pImageLibrary, SIGNAL(downloadProgress(int,qint64,qint64)), this, SLOT(downloadProgress(int,qint64,qint64)));
+	connect(m_pImageLibrary, SIGNAL(downloadFinished(int,QString,bool)), this, SLOT(downloadFinished(int,QString,bool)));
+	connect(m_pImageList->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(requestVisibleThumbnails()));
+	connect(m_pImageList, SIGNAL(currentRowChanged(int)), this, SLOT(currentRowChanged(int)));
+	connect(m_pDownloadButton, SIGNAL(clicked()), this, SLOT(downloadClicked()));
+	connect(m_pOriginalButton, SIGNAL(clicked()), this, SLOT(downloadClicked()));
+	connect(pCloseButton, SIGNAL(clicked()), this, SLOT(reject()));
+}
+
+// -----------------------------------------------------------------------
+CGalleryDialog::~CGalleryDialog() {
+	// Intentionally left blank
+}
+
+// -----------------------------------------------------------------------
+void CGalleryDialog::showEvent(QShowEvent * pEvent) {
+	QDialog::showEvent(pEvent);
+	m_pMainController->setPlayModeEnabled(true); // The image list follows, see imageListChanged()
+}
+
+// -----------------------------------------------------------------------
+void CGalleryDialog::done(int result) {
+	m_pMainController->setPlayModeEnabled(false);
+	QDialog::done(result);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: the visible thumbnails are shown resp. loaded first, the
+// others are prefetched
+void CGalleryDialog::imageListChanged() {
+	const auto & images = m_pImageLibrary->getImages();
+	m_pImageList->clear();
+	for (int index = 0; index < (int)images.size(); index++)
+		new QListWidgetItem(images[index].name, m_pImageList);
+	m_pStatusLabel->setText(QString("%1 images").arg(images.size()));
+	requestVisibleThumbnails();
+	m_pImageLibrary->prefetchThumbnails();
+}
+
+// -----------------------------------------------------------------------
+bool CGalleryDialog::isVisible(int index) const {
+	QListWidgetItem * pItem = m_pImageList->item(index);
+	return pItem != nullptr && m_pImageList->visualItemRect(pItem).intersects(m_pImageList->viewport()->rect());
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: a prefetched thumbnail stays in the pack until it is visible
+void CGalleryDialog::thumbnailAvailable(int index) {
+	QListWidgetItem * pItem = m_pImageList->item(index);
+	if (pItem == nullptr || !pItem->icon().isNull() || !isVisible(index))
+		return;
+	QPixmap pixmap;
+	if (pixmap.loadFromData(m_pImageLibrary->getCachedThumbnail(index), "JPG"))
+		pItem->setIcon(QIcon(pixmap));
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: the visible thumbnails precede the prefetched ones
+void CGalleryDialog::requestVisibleThumbnails() {
+	for (int index = 0; index < m_pImageList->count(); index++)
+		if (m_pImageList->item(index)->icon().isNull() && isVisible(index))
+			m_pImageLibrary->requestThumbnail(index);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CGalleryDialog::currentRowChanged(int index) {
+	m_pPreviewLabel->clear();
+	m_pImageLibrary->requestScreennail(index);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CGalleryDialog::screennailAvailable(int index) {
+	QPixmap pixmap;
+	if (index == m_pImageList->currentRow() && pixmap.loadFromData(m_pImageLibrary->getCachedScreennail(index), "JPG"))
+		m_pPreviewLabel->setPixmap(pixmap.scaled(SCREENNAIL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: downloads the selected image to the pictures directory
+void CGalleryDialog::downloadClicked() {
+	const int index = m_pImageList->currentRow();
+	if (index < 0)
+		return;
+	const QString dir = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation) + "/OlyCamera-RC";
+	QDir().mkpath(dir);
+	const CImageLibrary::ESize size = (sender() == m_pOriginalButton) ? CImageLibrary::ES_Original : CImageLibrary::ES_2048;
+	m_pImageLibrary->download(index, size, dir + "/" + m_pImageLibrary->getImages()[index].name);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CGalleryDialog::downloadProgress(int index, qint64 received, qint64 total) {
+	const QString name = m_pImageLibrary->getImages()[index].name;
+	if (total > 0)	m_pStatusLabel->setText(QString("%1: %2 %").arg(name).arg(received * 100 / total));
+	else			m_pStatusLabel->setText(QString("%1: %2 kB").arg(name).arg(received / 1024));
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CGalleryDialog::downloadFinished(int, QString fileName, bool ok) {
+	m_pStatusLabel->setText(ok ? QString("Saved %1").arg(fileName) : QString("Download of %1 failed").arg(fileName));
+}
+
+}}} // End namespaces
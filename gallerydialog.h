@@ -0,0 +1,87 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_GALLERYDIALOG_H
+#define DE_BSWALZ_OLYCAMERARC_GALLERYDIALOG_H
+
+/**
+ * OlympusCamera-RemoteControl: gallery of the images on the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include <QDialog>
+#include <QString>
+
+class QLabel;
+class QListWidget;
+class QPushButton;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+class IMainController;
+class CImageLibrary;
+
+// -----------------------------------------------------------------------
+// Class CGalleryDialog
+// Thumbnails of the images on the camera, download of the selected image.
+// The camera is in play mode while the dialog is open. Thumbnails are
+// decoded when they become visible only, missing ones are loaded visible
+// ones first. The selected image is shown as screennail.
+// -----------------------------------------------------------------------
+class CGalleryDialog : public QDialog {
+	Q_OBJECT
+public:
+	CGalleryDialog(IMainController *, QWidget * pParent = nullptr);
+	virtual ~CGalleryDialog();
+
+protected:
+	virtual void showEvent(QShowEvent *) override;
+	virtual void done(int) override;
+
+protected slots:
+	void	imageListChanged();
+	void	thumbnailAvailable(int index);
+	void	screennailAvailable(int index);
+	void	requestVisibleThumbnails();
+	void	currentRowChanged(int index);
+	void	downloadClicked();
+	void	downloadProgress(int index, qint64 received, qint64 total);
+	void	downloadFinished(int index, QString fileName, bool ok);
+
+private:
+	bool	isVisible(int index) const;
+
+	IMainController *	m_pMainController;
+	CImageLibrary *		m_pImageLibrary;
+	QListWidget *		m_pImageList;
+	QLabel *			m_pPreviewLabel;
+	QLabel *			m_pStatusLabel;
+	QPushButton *		m_pDownloadButton;
+	QPushButton *		m_pOriginalButton;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_GALLERYDIALOG_H
@@ -0,0 +1,300 @@
+/**
+ * OlympusCamera-RemoteControl: image list, thumbnails and downloads
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "imagelibrary.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkRequest>
+#include <QtNetwork/QNetworkReply>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CImageInfo
+// -----------------------------------------------------------------------
+QByteArray CImageInfo::getCacheKey() const {
+	const QByteArray key = QString("%1,%2,%3,%4").arg(getPath()).arg(size).arg(date).arg(time).toUtf8();
+	return QCryptographicHash::hash(key, QCryptographicHash::Sha1);
+}
+
+// -----------------------------------------------------------------------
+// Class CImageLibrary
+// -----------------------------------------------------------------------
+CImageLibrary::CImageLibrary(QNetworkAccessManager * pNetworkAccessManager, QObject * pParent)
+	: QObject(pParent), m_pNetworkAccessManager(pNetworkAccessManager), m_PendingDirectories(0) {
+	// Intentionally left blank
+}
+
+// -----------------------------------------------------------------------
+CImageLibrary::~CImageLibrary() {
+	cancel();
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::init(const std::string & cameraAddress, const QString & cacheDir) {
+	m_BaseUrl = "http://" + QString::fromStdString(cameraAddress);
+	if (!m_ThumbnailPack.isOpen())
+		m_ThumbnailPack.open(cacheDir);
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::requestImageList() {
+	m_Images.clear();
+	m_PendingDirectories = 0;
+	requestDirectory("/DCIM");
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::requestDirectory(const QString & dir) {
+	QNetworkRequest request(QUrl(m_BaseUrl + "/get_imglist.cgi?DIR=" + dir));
+	request.setHeader(QNetworkRequest::UserAgentHeader, "OlympusCameraKit");
+	QNetworkReply * pReply = m_pNetworkAccessManager->get(request);
+	connect(pReply, SIGNAL(finished()), this, SLOT(imageListFinished()));
+	m_PendingDirectories++;
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: reply of get_imglist.cgi, subdirectories are requested as well
+void CImageLibrary::imageListFinished() {
+	QNetworkReply * pReply = qobject_cast<QNetworkReply*>(sender());
+	if (pReply == nullptr)
+		return;
+	pReply->deleteLater();
+	m_PendingDirectories--;
+	if (pReply->error() == QNetworkReply::NoError)
+		parseImageList(pReply->readAll());
+	else
+		qDebug("Image list: %s", qPrintable(pReply->errorString()));
+	if (m_PendingDirectories == 0)
+		emit imageListChanged();
+}
+
+// -----------------------------------------------------------------------
+// First line "VER_100", then one entry per line
+void CImageLibrary::parseImageList(const QByteArray & reply) {
+	for (const QByteArray & line : reply.split('\n')) {
+		const QList<QByteArray> fields = line.trimmed().split(',');
+		if (fields.size() < 6)
+			continue;
+		CImageInfo info;
+		info.dir       = QString::fromLatin1(fields[0]);
+		info.name      = QString::fromLatin1(fields[1]);
+		info.size      = fields[2].toLongLong();
+		info.attribute = fields[3].toInt();
+		info.date      = fields[4].toInt();
+		info.time      = fields[5].toInt();
+		if (info.attribute & 0x10)
+			requestDirectory(info.getPath());
+		else
+			m_Images.push_back(info);
+		}
+}
+
+// -----------------------------------------------------------------------
+// A lookup in the index only, no file access
+bool CImageLibrary::isThumbnailCached(int index) const {
+	return index >= 0 && index < (int)m_Images.size() &&
+		   m_ThumbnailPack.contains(m_Images[index].getCacheKey(), CThumbnailPack::EK_Thumbnail);
+}
+
+// -----------------------------------------------------------------------
+QByteArray CImageLibrary::getCachedThumbnail(int index) {
+	if (index < 0 || index >= (int)m_Images.size())
+		return QByteArray();
+	return m_ThumbnailPack.get(m_Images[index].getCacheKey(), CThumbnailPack::EK_Thumbnail);
+}
+
+// -----------------------------------------------------------------------
+QByteArray CImageLibrary::getCachedScreennail(int index) {
+	if (index < 0 || index >= (int)m_Images.size())
+		return QByteArray();
+	return m_ThumbnailPack.get(m_Images[index].getCacheKey(), CThumbnailPack::EK_Screennail);
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::requestThumbnail(int index) {
+	requestPreview(index, ET_Thumbnail, true);
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::requestScreennail(int index) {
+	requestPreview(index, ET_Screennail, true);
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::prefetchThumbnails() {
+	for (int index = 0; index < (int)m_Images.size(); index++)
+		requestPreview(index, ET_Thumbnail, false);
+}
+
+// -----------------------------------------------------------------------
+// A cached preview is signalled at once (requested) or skipped (prefetched)
+void CImageLibrary::requestPreview(int index, ETransfer type, bool priority) {
+	if (index < 0 || index >= (int)m_Images.size())
+		return;
+	const CThumbnailPack::EKind kind = (type == ET_Thumbnail) ? CThumbnailPack::EK_Thumbnail : CThumbnailPack::EK_Screennail;
+	if (m_ThumbnailPack.contains(m_Images[index].getCacheKey(), kind)) {
+		if (priority && type == ET_Thumbnail)	emit thumbnailAvailable(index);
+		else if (priority)						emit screennailAvailable(index);
+		return;
+		}
+	CTransfer transfer;
+	transfer.type  = type;
+	transfer.index = index;
+	transfer.url   = m_BaseUrl + ((type == ET_Thumbnail) ? "/get_thumbnail.cgi?DIR=" : "/get_screennail.cgi?DIR=") + m_Images[index].getPath();
+	enqueue(transfer, priority);
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::download(int index, ESize size, const QString & fileName) {
+	if (index < 0 || index >= (int)m_Images.size())
+		return;
+	CTransfer transfer;
+	transfer.type     = ET_Download;
+	transfer.index    = index;
+	transfer.url      = (size == ES_Original) ? m_BaseUrl + m_Images[index].getPath()
+											  : QString("%1/get_resizeimg.cgi?DIR=%2&size=%3").arg(m_BaseUrl, m_Images[index].getPath()).arg((int)size);
+	transfer.fileName = fileName;
+	enqueue(transfer, true);
+}
+
+// -----------------------------------------------------------------------
+// A transfer of the same URL already queued or running is not repeated
+void CImageLibrary::enqueue(const CTransfer & transfer, bool priority) {
+	for (const auto & running : m_Transfers)
+		if (running.second.url == transfer.url)
+			return;
+	for (auto it = m_Queue.begin(); it != m_Queue.end(); ++it) {
+		if (it->url == transfer.url) {
+			if (!priority)
+				return;
+			m_Queue.erase(it);
+			break;
+			}
+		}
+	if (priority)	m_Queue.push_front(transfer);
+	else			m_Queue.push_back(transfer);
+	startTransfers();
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::startTransfers() {
+	while (!m_Queue.empty() && m_Transfers.size() < (size_t)MAX_PARALLEL_DOWNLOADS) {
+		CTransfer transfer = m_Queue.front();
+		m_Queue.pop_front();
+
+		if (transfer.type == ET_Download) {
+			QDir().mkpath(QFileInfo(transfer.fileName).absolutePath());
+			transfer.pFile = new QSaveFile(transfer.fileName);
+			if (!transfer.pFile->open(QIODevice::WriteOnly)) {
+				delete transfer.pFile;
+				emit downloadFinished(transfer.index, transfer.fileName, false);
+				continue;
+				}
+			}
+		QNetworkRequest request{QUrl(transfer.url)};
+		request.setHeader(QNetworkRequest::UserAgentHeader, "OlympusCameraKit");
+		QNetworkReply * pReply = m_pNetworkAccessManager->get(request);
+		pReply->setReadBufferSize(READ_BUFFER_SIZE); // Qt stops reading from the socket when full
+		connect(pReply, SIGNAL(readyRead()), this, SLOT(transferReadyRead()));
+		connect(pReply, SIGNAL(finished()), this, SLOT(transferFinished()));
+		m_Transfers[pReply] = transfer;
+		}
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: writes the received chunk, a preview is collected in memory
+void CImageLibrary::transferReadyRead() {
+	QNetworkReply * pReply = qobject_cast<QNetworkReply*>(sender());
+	auto it = m_Transfers.find(pReply);
+	if (it == m_Transfers.end())
+		return;
+	if (it->second.type != ET_Download) {
+		it->second.data.append(pReply->readAll());
+		return;
+		}
+	char buffer[16 * 1024];
+	qint64 length;
+	while ((length = pReply->read(buffer, sizeof(buffer))) > 0)
+		it->second.pFile->write(buffer, length);
+	emit downloadProgress(it->second.index, it->second.pFile->pos(),
+						  pReply->header(QNetworkRequest::ContentLengthHeader).toLongLong());
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: a download is renamed to its final name on success only, a
+// preview is appended to the pack
+void CImageLibrary::transferFinished() {
+	QNetworkReply * pReply = qobject_cast<QNetworkReply*>(sender());
+	auto it = m_Transfers.find(pReply);
+	if (it == m_Transfers.end())
+		return;
+	transferReadyRead();
+	CTransfer transfer = it->second;
+	m_Transfers.erase(it);
+	pReply->deleteLater();
+
+	if (transfer.type == ET_Download) {
+		bool ok = pReply->error() == QNetworkReply::NoError && transfer.pFile->size() > 0;
+		if (ok)		ok = transfer.pFile->commit();
+		else		transfer.pFile->cancelWriting();
+		delete transfer.pFile;
+		emit downloadFinished(transfer.index, transfer.fileName, ok);
+		}
+	else if (pReply->error() == QNetworkReply::NoError && !transfer.data.isEmpty() && transfer.index < (int)m_Images.size()) {
+		const CThumbnailPack::EKind kind = (transfer.type == ET_Thumbnail) ? CThumbnailPack::EK_Thumbnail : CThumbnailPack::EK_Screennail;
+		if (m_ThumbnailPack.append(m_Images[transfer.index].getCacheKey(), kind, transfer.data)) {
+			if (transfer.type == ET_Thumbnail)	emit thumbnailAvailable(transfer.index);
+			else								emit screennailAvailable(transfer.index);
+			}
+		}
+	startTransfers();
+}
+
+// -----------------------------------------------------------------------
+void CImageLibrary::cancel() {
+	m_Queue.clear();
+	std::map<QNetworkReply*, CTransfer> transfers;
+	transfers.swap(m_Transfers);
+	for (auto & transfer : transfers) {
+		transfer.first->abort();
+		transfer.first->deleteLater();
+		if (transfer.second.pFile != nullptr) {
+			transfer.second.pFile->cancelWriting();
+			delete transfer.second.pFile;
+			}
+		}
+}
+
+}}} // End namespaces
@@ -0,0 +1,149 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_IMAGELIBRARY_H
+#define DE_BSWALZ_OLYCAMERARC_IMAGELIBRARY_H
+
+/**
+ * OlympusCamera-RemoteControl: image list, thumbnails and downloads
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "thumbnailpack.h"
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <deque>
+#include <map>
+#include <vector>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QSaveFile;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CImageInfo
+// Entry of get_imglist.cgi: "dir,name,size,attribute,date,time"
+// -----------------------------------------------------------------------
+class CImageInfo {
+public:
+	CImageInfo() : size(0), attribute(0), date(0), time(0) {}
+	QString	getPath() const { return dir + "/" + name; }
+	/** Key of the thumbnail cache: SHA-1 of path, size, date and time */
+	QByteArray	getCacheKey() const;
+
+	QString	dir;		// e.g. "/DCIM/100OLYMP"
+	QString	name;		// e.g. "P1010001.JPG"
+	qint64	size;		// Bytes
+	int		attribute;	// FAT attribute, 0x10: directory
+	int		date;		// FAT date
+	int		time;		// FAT time
+};
+
+// -----------------------------------------------------------------------
+// Class CImageLibrary
+// Images on the camera (play mode): image list, thumbnails and downloads.
+// Thumbnails and screennails are cached in a memory-mapped pack file
+// (see CThumbnailPack), thumbnails are prefetched in the background and
+// requested with priority when they become visible. Downloads are
+// streamed to disk in chunks as they arrive (limited read buffer), an
+// image is never held in memory as a whole.
+// -----------------------------------------------------------------------
+class CImageLibrary : public QObject {
+	Q_OBJECT
+public:
+	static const int    MAX_PARALLEL_DOWNLOADS = 3;		// The camera's HTTP server is small
+	static const qint64 READ_BUFFER_SIZE       = 64 * 1024;
+	/** Parameter "size" of get_resizeimg.cgi, 0: original file */
+	enum ESize { ES_Original = 0, ES_1024 = 1024, ES_1600 = 1600, ES_1920 = 1920, ES_2048 = 2048 };
+
+	CImageLibrary(QNetworkAccessManager *, QObject * pParent = nullptr);
+	virtual ~CImageLibrary();
+
+	/** Camera address "host[:port]" and directory of the thumbnail cache */
+	void	init(const std::string & cameraAddress, const QString & cacheDir);
+	/** Requests the list of all images below /DCIM, see imageListChanged() */
+	void	requestImageList();
+	const std::vector<CImageInfo> & getImages() const { return m_Images; }
+	bool	isThumbnailCached(int index) const;
+	/** Cached JPEG data (mapped, not copied) or empty */
+	QByteArray	getCachedThumbnail(int index);
+	QByteArray	getCachedScreennail(int index);
+	/** Thumbnail of a visible image, before all prefetched ones */
+	void	requestThumbnail(int index);
+	/** Screennail (640x480) of the selected image */
+	void	requestScreennail(int index);
+	/** Thumbnails of all images not yet cached */
+	void	prefetchThumbnails();
+	/** Downloads an image to fileName, see downloadFinished() */
+	void	download(int index, ESize size, const QString & fileName);
+	/** Cancels the queued and running transfers */
+	void	cancel();
+
+signals:
+	void	imageListChanged();
+	void	thumbnailAvailable(int index);
+	void	screennailAvailable(int index);
+	void	downloadProgress(int index, qint64 received, qint64 total);
+	void	downloadFinished(int index, QString fileName, bool ok);
+
+protected slots:
+	void	transferReadyRead();
+	void	transferFinished();
+	void	imageListFinished();
+
+private:
+	enum ETransfer { ET_Thumbnail, ET_Screennail, ET_Download };
+	class CTransfer {
+	public:
+		CTransfer() : type(ET_Thumbnail), index(0), pFile(nullptr) {}
+		ETransfer	type;
+		int			index;
+		QString		url;
+		QString		fileName;	// ET_Download
+		QSaveFile *	pFile;		// ET_Download
+		QByteArray	data;		// ET_Thumbnail, ET_Screennail: a few kB, appended to the pack
+	};
+
+	void	requestDirectory(const QString & dir);
+	void	parseImageList(const QByteArray &);
+	void	enqueue(const CTransfer &, bool priority);
+	void	startTransfers();
+	void	requestPreview(int index, ETransfer, bool priority);
+
+	QNetworkAccessManager *	m_pNetworkAccessManager;
+	QString					m_BaseUrl;		// "http://host[:port]"
+	CThumbnailPack			m_ThumbnailPack;
+	std::vector<CImageInfo>	m_Images;
+	int						m_PendingDirectories;
+	std::deque<CTransfer>	m_Queue;
+	std::map<QNetworkReply*, CTransfer> m_Transfers;	// In flight
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_IMAGELIBRARY_H
@@ -0,0 +1,154 @@
+/**
+ * OlympusCamera-RemoteControl: latency measurement of the LiveView path
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "latencystatistics.h"
+#include <algorithm>
+#include <fstream>
+#include <stdio.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLatencyHistogram
+// -----------------------------------------------------------------------
+CLatencyHistogram::CLatencyHistogram()
+	: m_Buckets((OCTAVES + 1) * SUB_BUCKETS, 0), m_Count(0), m_Max(0) {}
+
+// -----------------------------------------------------------------------
+// Bucket 0..15: 0..15 us, then 16 buckets per power of two
+int CLatencyHistogram::getBucket(int64_t durationUs) {
+	if (durationUs < SUB_BUCKETS)
+		return (durationUs > 0) ? (int)durationUs : 0;
+	int exponent = 63 - __builtin_clzll((unsigned long long)durationUs);	// >= 4
+	if (exponent > OCTAVES + 3)
+		return (OCTAVES + 1) * SUB_BUCKETS - 1;
+	const int subBucket = (int)((durationUs >> (exponent - 4)) & (SUB_BUCKETS - 1));
+	return (exponent - 3) * SUB_BUCKETS + subBucket;
+}
+
+// -----------------------------------------------------------------------
+// Upper bound in us
+int64_t CLatencyHistogram::getBucketUpperBound(int bucket) {
+	if (bucket < SUB_BUCKETS)
+		return bucket + 1;
+	const int exponent  = bucket / SUB_BUCKETS + 3;
+	const int subBucket = bucket % SUB_BUCKETS;
+	return ((int64_t)(SUB_BUCKETS + subBucket + 1)) << (exponent - 4);
+}
+
+// -----------------------------------------------------------------------
+void CLatencyHistogram::add(int64_t durationNs) {
+	if (durationNs < 0)
+		return;
+	m_Buckets[getBucket(durationNs / 1000)]++;
+	m_Count++;
+	if (durationNs > m_Max) m_Max = durationNs;
+}
+
+// -----------------------------------------------------------------------
+void CLatencyHistogram::reset() {
+	std::fill(m_Buckets.begin(), m_Buckets.end(), 0);
+	m_Count = 0;
+	m_Max   = 0;
+}
+
+// -----------------------------------------------------------------------
+int64_t CLatencyHistogram::getPercentile(double percent) const {
+	if (m_Count == 0)
+		return 0;
+	const uint64_t threshold = (uint64_t)(percent / 100.0 * m_Count + 0.5);
+	uint64_t sum = 0;
+	for (unsigned int i = 0; i < m_Buckets.size(); i++) {
+		sum += m_Buckets[i];
+		if (sum >= threshold && sum > 0) {
+			const int64_t bound = getBucketUpperBound(i) * 1000;
+			return (bound < m_Max) ? bound : m_Max;
+			}
+		}
+	return m_Max;
+}
+
+
+// -----------------------------------------------------------------------
+// Class CLatencyStatistics
+// -----------------------------------------------------------------------
+void CLatencyStatistics::addFrame(int64_t firstPacketTime, int64_t completeTime, int64_t decodedTime, int64_t paintTime) {
+	if (firstPacketTime > 0 && completeTime > 0)	m_Histograms[ELS_Reassembly].add(completeTime - firstPacketTime);
+	if (completeTime > 0 && decodedTime > 0)		m_Histograms[ELS_Decode].add(decodedTime - completeTime);
+	if (decodedTime > 0 && paintTime > 0)			m_Histograms[ELS_Display].add(paintTime - decodedTime);
+	if (firstPacketTime > 0 && paintTime > 0)		m_Histograms[ELS_Total].add(paintTime - firstPacketTime);
+}
+
+// -----------------------------------------------------------------------
+void CLatencyStatistics::reset() {
+	for (auto & histogram : m_Histograms)
+		histogram.reset();
+}
+
+// -----------------------------------------------------------------------
+const char * CLatencyStatistics::getStageName(EStage stage) {
+	switch (stage) {
+		case ELS_Reassembly :	return "Reassembly";
+		case ELS_Decode :		return "Decode";
+		case ELS_Display :		return "Display";
+		case ELS_Total :		return "Total";
+		default:				return "";
+		}
+}
+
+// -----------------------------------------------------------------------
+std::string CLatencyStatistics::toString() const {
+	std::string text;
+	char line[128];
+	for (int i = 0; i < ELS_Count; i++) {
+		const CLatencyHistogram & histogram = m_Histograms[i];
+		snprintf(line, sizeof(line), "%-10s p50 %6.1f  p95 %6.1f  p99 %6.1f ms (%llu)\n", getStageName((EStage)i),
+				 histogram.getPercentile(50.0) / 1e6, histogram.getPercentile(95.0) / 1e6,
+				 histogram.getPercentile(99.0) / 1e6, (unsigned long long)histogram.getCount());
+		text += line;
+		}
+	return text;
+}
+
+// -----------------------------------------------------------------------
+bool CLatencyStatistics::dump(const std::string & fileName) const {
+	std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+	file << toString() << "\n# stage percentile latency_ms\n";
+	const double percentiles[] = { 50.0, 75.0, 90.0, 95.0, 99.0, 99.9, 100.0 };
+	for (int i = 0; i < ELS_Count; i++) {
+		for (double percentile : percentiles)
+			file << getStageName((EStage)i) << " " << percentile << " "
+				 << m_Histograms[i].getPercentile(percentile) / 1e6 << "\n";
+		}
+	return file.good();
+}
+
+}}} // End namespaces
@@ -0,0 +1,101 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_LATENCYSTATISTICS_H
+#define DE_BSWALZ_OLYCAMERARC_LATENCYSTATISTICS_H
+
+/**
+ * OlympusCamera-RemoteControl: latency measurement of the LiveView path
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLatencyClock
+// Monotonic clock shared by all threads
+// -----------------------------------------------------------------------
+class CLatencyClock {
+public:
+	/** Nanoseconds since an arbitrary, fixed point in time */
+	static int64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+// -----------------------------------------------------------------------
+// Class CLatencyHistogram
+// Logarithmic histogram of durations, 16 buckets per power of two
+// (resolution about 4%) from 1 us up to about one minute.
+// -----------------------------------------------------------------------
+class CLatencyHistogram {
+public:
+	static const int SUB_BUCKETS = 16;
+	static const int OCTAVES     = 26;
+
+	CLatencyHistogram();
+	void		add(int64_t durationNs);
+	void		reset();
+	uint64_t	getCount() const { return m_Count; }
+	/** Duration in ns, below which the given percentage (0..100) of the values is */
+	int64_t		getPercentile(double percent) const;
+	int64_t		getMax() const { return m_Max; }
+private:
+	static int		getBucket(int64_t durationUs);
+	static int64_t	getBucketUpperBound(int bucket);
+	std::vector<uint32_t>	m_Buckets;
+	uint64_t				m_Count;
+	int64_t					m_Max;
+};
+
+// -----------------------------------------------------------------------
+// Class CLatencyStatistics
+// Latencies of the LiveView stages: first RTP packet -> marker packet
+// (reassembly) -> end of decode -> paint (display)
+// -----------------------------------------------------------------------
+class CLatencyStatistics {
+public:
+	enum EStage { ELS_Reassembly, ELS_Decode, ELS_Display, ELS_Total, ELS_Count };
+
+	/** Timestamps of CLatencyClock, 0 if not available */
+	void		addFrame(int64_t firstPacketTime, int64_t completeTime, int64_t decodedTime, int64_t paintTime);
+	void		reset();
+	const CLatencyHistogram & getHistogram(EStage stage) const { return m_Histograms[stage]; }
+	/** Multi-line text with p50/p95/p99 in ms of each stage */
+	std::string	toString() const;
+	/** Writes toString() and the raw histograms to the file */
+	bool		dump(const std::string & fileName) const;
+	static const char * getStageName(EStage);
+private:
+	CLatencyHistogram	m_Histograms[ELS_Count];
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_LATENCYSTATISTICS_H
@@ -0,0 +1,139 @@
+/**
+ * OlympusCamera-RemoteControl: decoder of LiveView images
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "liveviewdecoder.h"
+#include "latencystatistics.h"
+#include "tracing.h"
+#include <QRunnable>
+#include <QBuffer>
+#include <QImageReader>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+namespace {
+// -----------------------------------------------------------------------
+// Anonymous class CDecodeJob
+// -----------------------------------------------------------------------
+class CDecodeJob : public QRunnable {
+public:
+	CDecodeJob(CLiveViewDecoder * pDecoder, const CLiveViewFrame & frame, const QSize & targetSize,
+			   const CFrameAnalyzer & analyzer, quint64 sequence)
+		: QRunnable(), m_pDecoder(pDecoder), m_Frame(frame), m_TargetSize(targetSize), m_Analyzer(analyzer), m_Sequence(sequence) {}
+	virtual void run() override {
+		OLYCAMERARC_TRACE_SCOPE("LiveView decode");
+		QImage image = CLiveViewDecoder::decodeScaled(m_Frame.data, m_TargetSize);
+		m_Frame.data        = QByteArray();	// Releases the frame buffer as early as possible
+		m_Analyzer.analyze(image);
+		m_Frame.decodedTime = CLatencyClock::now();
+		emit m_pDecoder->jobFinished(image, m_Frame, m_Sequence);
+	}
+private:
+	CLiveViewDecoder *	m_pDecoder;
+	CLiveViewFrame		m_Frame;
+	QSize				m_TargetSize;
+	CFrameAnalyzer		m_Analyzer;
+	quint64				m_Sequence;
+};
+
+} // End anonymous namespace
+
+// -----------------------------------------------------------------------
+// Class CLiveViewDecoder
+// -----------------------------------------------------------------------
+CLiveViewDecoder::CLiveViewDecoder(QObject * pParent)
+	: QObject(pParent), m_HasPendingFrame(false), m_JobsInFlight(0), m_NextSequence(1),
+	  m_LastDisplayedSequence(0), m_DecodedFrames(0), m_DroppedFrames(0) {
+	qRegisterMetaType<CLiveViewFrame>("CLiveViewFrame");
+	m_ThreadPool.setMaxThreadCount(WORKER_COUNT);
+	connect(this, &CLiveViewDecoder::jobFinished, this, &CLiveViewDecoder::onJobFinished, Qt::QueuedConnection);
+}
+
+// -----------------------------------------------------------------------
+CLiveViewDecoder::~CLiveViewDecoder() {
+	m_ThreadPool.waitForDone();
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewDecoder::setTargetSize(const QSize & size) {
+	m_TargetSize = size;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewDecoder::decode(const CLiveViewFrame & frame) {
+	if (m_JobsInFlight < WORKER_COUNT) {
+		startJob(frame);
+		return;
+		}
+	// All workers busy: the latest frame supersedes a waiting one
+	if (m_HasPendingFrame)
+		m_DroppedFrames++;
+	m_PendingFrame    = frame;
+	m_HasPendingFrame = true;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewDecoder::startJob(const CLiveViewFrame & frame) {
+	CDecodeJob * pJob = new CDecodeJob(this, frame, m_TargetSize, m_Analyzer, m_NextSequence++);
+	pJob->setAutoDelete(true);
+	m_JobsInFlight++;
+	m_ThreadPool.start(pJob);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot, invoked in the GUI thread
+void CLiveViewDecoder::onJobFinished(QImage image, CLiveViewFrame frame, quint64 sequence) {
+	m_JobsInFlight--;
+	if (m_HasPendingFrame) {
+		m_HasPendingFrame = false;
+		startJob(m_PendingFrame);
+		m_PendingFrame = CLiveViewFrame();
+		}
+
+	if (sequence < m_LastDisplayedSequence || image.isNull()) {	// Overtaken by a newer frame or not decodable
+		m_DroppedFrames++;
+		return;
+		}
+	m_LastDisplayedSequence = sequence;
+	m_DecodedFrames++;
+	emit imageDecoded(image, frame);
+}
+
+// -----------------------------------------------------------------------
+QImage CLiveViewDecoder::decodeScaled(const QByteArray & jpeg, const QSize & targetSize) {
+	QBuffer buffer;
+	buffer.setData(jpeg);
+	buffer.open(QIODevice::ReadOnly);
+	QImageReader reader(&buffer, "jpeg");
+	const QSize size = reader.size();
+	if (size.isValid() && targetSize.isValid() && !targetSize.isEmpty() &&
+		(size.width() > targetSize.width() || size.height() > targetSize.height()))
+		reader.setScaledSize(size.scaled(targetSize, Qt::KeepAspectRatio)); // Scaled by libjpeg while decoding
+	return reader.read();
+}
+
+}}} // End namespaces
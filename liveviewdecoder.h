@@ -0,0 +1,99 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_LIVEVIEWDECODER_H
+#define DE_BSWALZ_OLYCAMERARC_LIVEVIEWDECODER_H
+
+/**
+ * OlympusCamera-RemoteControl: decoder of LiveView images
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include <QObject>
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QThreadPool>
+#include "maincontroller.h"
+#include "frameanalysis.h"
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLiveViewDecoder
+// Decodes LiveView JPEGs by a pool of worker threads directly to the
+// display size (JPEG DCT scaling of QImageReader). To be used by the GUI
+// thread: if all workers are busy, only the latest frame is kept and older
+// ones are dropped, results older than the displayed one are discarded.
+// The enabled overlays (focus peaking, histogram) are drawn by the worker.
+// -----------------------------------------------------------------------
+class CLiveViewDecoder : public QObject {
+	Q_OBJECT
+public:
+	static const int WORKER_COUNT = 2;
+
+	CLiveViewDecoder(QObject * pParent = nullptr);
+	virtual ~CLiveViewDecoder();
+
+	/** Size of the display area, images are downscaled (never upscaled) to it */
+	void	setTargetSize(const QSize &);
+	/** Enqueues a frame for decoding */
+	void	decode(const CLiveViewFrame & frame);
+	/** Overlays, effective from the next enqueued frame */
+	void	setFocusPeakingEnabled(bool enabled) { m_Analyzer.setFocusPeakingEnabled(enabled); }
+	void	setHistogramEnabled(bool enabled) { m_Analyzer.setHistogramEnabled(enabled); }
+
+	quint64	getDecodedFrames() const { return m_DecodedFrames; }
+	quint64	getDroppedFrames() const { return m_DroppedFrames; }
+
+	/** Decodes the JPEG, scaled down to fit into targetSize. May be called by any thread. */
+	static QImage decodeScaled(const QByteArray & jpeg, const QSize & targetSize);
+
+signals:
+	/** A decoded, ready to blit image, frame without JPEG data */
+	void	imageDecoded(QImage, CLiveViewFrame);
+	/** Internal: result of a worker */
+	void	jobFinished(QImage, CLiveViewFrame, quint64);
+
+protected slots:
+	void	onJobFinished(QImage, CLiveViewFrame, quint64);
+
+private:
+	void	startJob(const CLiveViewFrame & frame);
+
+	QThreadPool		m_ThreadPool;
+	QSize			m_TargetSize;
+	CFrameAnalyzer	m_Analyzer;
+	CLiveViewFrame	m_PendingFrame;
+	bool			m_HasPendingFrame;
+	int				m_JobsInFlight;
+	quint64			m_NextSequence;
+	quint64			m_LastDisplayedSequence;
+	quint64			m_DecodedFrames;
+	quint64			m_DroppedFrames;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_LIVEVIEWDECODER_H
@@ -0,0 +1,153 @@
+/**
+ * OlympusCamera-RemoteControl: adaptive LiveView quality
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "liveviewqualitycontroller.h"
+#include <QtGlobal>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+// Thresholds relative to the target frame rate resp. its frame interval
+const double DOWN_FPS_RATIO     = 0.75;
+const double UP_FPS_RATIO       = 0.95;
+const double DOWN_DECODE_RATIO  = 1.0;	// Decoding slower than the frame rate
+const double UP_DECODE_RATIO    = 0.4;	// The next quality has about twice the pixels
+const double DOWN_LOSS_PERCENT  = 5.0;
+const double UP_LOSS_PERCENT    = 0.5;
+}
+
+// -----------------------------------------------------------------------
+// Class CLiveViewQualityController
+// -----------------------------------------------------------------------
+CLiveViewQualityController::CLiveViewQualityController(double targetFps)
+	: m_TargetFps(targetFps), m_Pinned(false), m_Quality(ELVQ_0320x0240), m_WindowStart(0), m_DiscardWindow(true),
+	  m_Frames(0), m_ReceivedPackets(0), m_WindowReceivedPackets(0), m_LostPackets(0), m_WindowLostPackets(0),
+	  m_GoodWindows(0), m_RequiredGoodWindows(UP_WINDOWS), m_SteppedUp(false), m_Fps(0.0), m_LossPercent(0.0), m_DecodeTime(0) {
+	// Intentionally left blank
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewQualityController::pin(ELiveViewQuality quality) {
+	m_Pinned  = true;
+	m_Quality = quality;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewQualityController::unpin() {
+	m_Pinned              = false;
+	m_GoodWindows         = 0;
+	m_RequiredGoodWindows = UP_WINDOWS;
+	m_SteppedUp           = false;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewQualityController::addFrame(int64_t completeTime, int64_t decodedTime) {
+	m_Frames++;
+	if (completeTime > 0 && decodedTime > completeTime)
+		m_DecodeTimes.add(decodedTime - completeTime);
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewQualityController::setPacketCounters(uint64_t receivedPackets, uint64_t lostPackets) {
+	if (receivedPackets < m_WindowReceivedPackets || lostPackets < m_WindowLostPackets) { // Counters reset
+		m_WindowReceivedPackets = receivedPackets;
+		m_WindowLostPackets     = lostPackets;
+		}
+	m_ReceivedPackets = receivedPackets;
+	m_LostPackets     = lostPackets;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewQualityController::restart(int64_t now) {
+	m_WindowStart           = now;
+	m_DiscardWindow         = true;
+	m_Frames                = 0;
+	m_DecodeTimes.reset();
+	m_WindowReceivedPackets = m_ReceivedPackets;
+	m_WindowLostPackets     = m_LostPackets;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewQualityController::setQuality(ELiveViewQuality quality, int64_t now) {
+	qDebug("LiveView quality %d -> %d: %.1f fps, %.2f%% loss, decode p90 %.1f ms", (int)m_Quality, (int)quality,
+		   m_Fps, m_LossPercent, m_DecodeTime / 1e6);
+	m_SteppedUp   = quality > m_Quality;
+	m_Quality     = quality;
+	m_GoodWindows = 0;
+	restart(now);
+}
+
+// -----------------------------------------------------------------------
+bool CLiveViewQualityController::evaluate(int64_t now) {
+	if (m_WindowStart == 0) {
+		restart(now);
+		return false;
+		}
+	const int64_t duration = now - m_WindowStart;
+	if (duration < EVALUATION_INTERVAL)
+		return false;
+
+	const uint64_t received = m_ReceivedPackets - m_WindowReceivedPackets;
+	const uint64_t lost     = m_LostPackets - m_WindowLostPackets;
+	const uint32_t frames   = m_Frames;
+	const bool     discard  = m_DiscardWindow || m_Pinned || received == 0;	// Not streaming
+	m_Fps         = frames * 1e9 / duration;
+	m_LossPercent = (received + lost > 0) ? 100.0 * lost / (received + lost) : 0.0;
+	m_DecodeTime  = m_DecodeTimes.getPercentile(90.0);
+	restart(now);
+	m_DiscardWindow = false;
+	if (discard)
+		return false;
+
+	const double frameInterval = 1e9 / m_TargetFps;
+	if (frames < (uint32_t)MIN_FRAMES || m_Fps < m_TargetFps * DOWN_FPS_RATIO || m_LossPercent > DOWN_LOSS_PERCENT ||
+		m_DecodeTime > frameInterval * DOWN_DECODE_RATIO) {
+		if (m_Quality == ELVQ_0320x0240) {
+			m_GoodWindows = 0;
+			return false;
+			}
+		if (m_SteppedUp) // The step up did not work out: more patience next time
+			m_RequiredGoodWindows = (m_RequiredGoodWindows * 2 < MAX_UP_WINDOWS) ? m_RequiredGoodWindows * 2 : MAX_UP_WINDOWS;
+		setQuality((ELiveViewQuality)(m_Quality - 1), now);
+		return true;
+		}
+	if (m_Fps >= m_TargetFps * UP_FPS_RATIO && m_LossPercent <= UP_LOSS_PERCENT && m_DecodeTime < frameInterval * UP_DECODE_RATIO) {
+		if (++m_GoodWindows >= m_RequiredGoodWindows && m_Quality < ELVQ_1280x0960) {
+			setQuality((ELiveViewQuality)(m_Quality + 1), now);
+			return true;
+			}
+		}
+	else {
+		m_GoodWindows = 0;
+		}
+	return false;
+}
+
+}}} // End namespaces
@@ -0,0 +1,106 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_LIVEVIEWQUALITYCONTROLLER_H
+#define DE_BSWALZ_OLYCAMERARC_LIVEVIEWQUALITYCONTROLLER_H
+
+/**
+ * OlympusCamera-RemoteControl: adaptive LiveView quality
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "types.h"
+#include "latencystatistics.h"
+#include <stdint.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLiveViewQualityController
+// Chooses "lvqty" from the measured LiveView path: displayed frame rate,
+// packet loss and decode time (marker packet -> decoded image) of each
+// evaluation window. A bad window steps down at once, stepping up needs
+// UP_WINDOWS good windows in a row; each step down after a step up
+// doubles this number (up to MAX_UP_WINDOWS), so the quality does not
+// oscillate at the capacity of the link. A window with received packets
+// but fewer than MIN_FRAMES complete frames is bad as well. The window
+// after a change or a start/stop of LiveView (restart()) is discarded,
+// as are windows without any packets. A pinned quality disables the
+// adaptation.
+// -----------------------------------------------------------------------
+class CLiveViewQualityController {
+public:
+	static const int64_t EVALUATION_INTERVAL = 2000000000LL;	// ns
+	static const int     UP_WINDOWS          = 3;
+	static const int     MAX_UP_WINDOWS      = 48;
+	static const int     MIN_FRAMES          = 5;				// Fewer frames while packets arrive: bad window
+
+	CLiveViewQualityController(double targetFps = 20.0);
+
+	void	setTargetFps(double fps) { m_TargetFps = fps; }
+	double	getTargetFps() const { return m_TargetFps; }
+	/** Fixes the quality, adaptation is resumed by unpin() */
+	void	pin(ELiveViewQuality);
+	void	unpin();
+	bool	isPinned() const { return m_Pinned; }
+	ELiveViewQuality getQuality() const { return m_Quality; }
+
+	/** Displayed frame, timestamps of CLatencyClock */
+	void	addFrame(int64_t completeTime, int64_t decodedTime);
+	/** Cumulative packet counters of the receiver */
+	void	setPacketCounters(uint64_t receivedPackets, uint64_t lostPackets);
+	/** Evaluates the window if EVALUATION_INTERVAL has elapsed, true if the quality has changed */
+	bool	evaluate(int64_t now);
+	/** Starts a new window, the next one is discarded. To be called on start and stop of LiveView. */
+	void	restart(int64_t now);
+
+	/** Measurements of the last evaluated window */
+	double	getFps() const { return m_Fps; }
+	double	getLossPercent() const { return m_LossPercent; }
+	int64_t	getDecodeTime() const { return m_DecodeTime; }	// p90, ns
+
+private:
+	void	setQuality(ELiveViewQuality, int64_t now);
+
+	double				m_TargetFps;
+	bool				m_Pinned;
+	ELiveViewQuality	m_Quality;
+	int64_t				m_WindowStart;
+	bool				m_DiscardWindow;
+	uint32_t			m_Frames;
+	CLatencyHistogram	m_DecodeTimes;
+	uint64_t			m_ReceivedPackets, m_WindowReceivedPackets;
+	uint64_t			m_LostPackets, m_WindowLostPackets;
+	int					m_GoodWindows;
+	int					m_RequiredGoodWindows;
+	bool				m_SteppedUp;		// Last change was a step up
+	double				m_Fps;
+	double				m_LossPercent;
+	int64_t				m_DecodeTime;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_LIVEVIEWQUALITYCONTROLLER_H
@@ -0,0 +1,266 @@
+/**
+ * OlympusCamera-RemoteControl: receiver of LiveView datagrams
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "liveviewreceiver.h"
+#include "rtpdatagramhandler.h"
+#include "main.h"
+#include "tracing.h"
+
+#include <QtNetwork/QUdpSocket>
+#include <QtNetwork/QNetworkDatagram>
+#include <QtNetwork/QHostAddress>
+#include <QSocketNotifier>
+#include <QDebug>
+
+#if defined(OLYCAMERARC_RECVMMSG)
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLiveViewReceiver
+// -----------------------------------------------------------------------
+CLiveViewReceiver::CLiveViewReceiver(CQMLBackend * pQMLBackend)
+	: QObject(), m_pQMLBackend(pQMLBackend), m_pUDPServerSocket(nullptr),
+	  m_pRTPDatagramHandler(new CRTPDatagramHandler()), m_LocalPort(0), m_ReceiveCalls(0),
+	  m_ReceivedDatagrams(0), m_ReceivedFrames(0), m_ReceivedPackets(0), m_LostPackets(0), m_NextStatisticsLog(STATISTICS_LOG_INTERVAL), m_BatchSize(DEFAULT_BATCH_SIZE), m_SocketFd(-1),
+	  m_pSocketNotifier(nullptr) {
+	registerAt(m_pRTPDatagramHandler, false);
+}
+
+// -----------------------------------------------------------------------
+CLiveViewReceiver::~CLiveViewReceiver() {
+	unregisterAt(m_pRTPDatagramHandler);
+	stopBatchedReceive();
+	delete m_pUDPServerSocket;
+	delete m_pRTPDatagramHandler;
+}
+
+// -----------------------------------------------------------------------
+double CLiveViewReceiver::getReceiveCallsPerFrame() const {
+	const quint64 frames = m_ReceivedFrames;
+	return (frames > 0) ? (double)m_ReceiveCalls / frames : 0.0;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewReceiver::logStatistics() {
+	const CRTPStatistics & stats = m_pRTPDatagramHandler->getStatistics();
+	qDebug("LiveView receive: %llu calls, %llu datagrams, %llu frames, %.2f calls/frame",
+		   (unsigned long long)m_ReceiveCalls, (unsigned long long)m_ReceivedDatagrams,
+		   (unsigned long long)m_ReceivedFrames, getReceiveCallsPerFrame());
+	qDebug("LiveView stream: %.2f%% loss, %u reordered, %u late, %u oversize, %u incomplete frames, %u dropped frames, %u superseded frames",
+		   stats.getLossPercent(), stats.reorderedPackets, stats.latePackets, stats.oversizePackets, stats.incompleteFrames, stats.droppedFrames,
+		   stats.supersededFrames);
+}
+
+// -----------------------------------------------------------------------
+// Inherited from View, invoked in the receiver thread
+void CLiveViewReceiver::update(const Model * pModel, void *) {
+	if (pModel != m_pRTPDatagramHandler)
+		return;
+	const CRTPStatistics & stats = m_pRTPDatagramHandler->getStatistics();
+	const quint64 frames = stats.completeFrames;
+	m_ReceivedFrames  = frames;
+	m_ReceivedPackets = stats.receivedPackets;
+	m_LostPackets     = stats.lostPackets;
+	if (frames >= m_NextStatisticsLog) {
+		logStatistics();
+		m_NextStatisticsLog = frames + STATISTICS_LOG_INTERVAL;
+		}
+	// The mailbox was empty: notifies the GUI (queued connection), which takes the latest frame
+	// by takeFrame(). Further frames replace it until the GUI has taken it.
+	m_pQMLBackend->lifeviewImageChanged(QVariant(frames));
+}
+
+// -----------------------------------------------------------------------
+CFrameBuffer * CLiveViewReceiver::takeFrame() {
+	return m_pRTPDatagramHandler->takeFrame();
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewReceiver::releaseFrame(CFrameBuffer * pFrame) {
+	m_pRTPDatagramHandler->releaseFrame(pFrame);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CLiveViewReceiver::start(const QString & localIpAddress) {
+	OLYCAMERARC_TRACE_THREAD_NAME("LiveView");
+	if (m_pUDPServerSocket != nullptr || m_SocketFd >= 0)
+		return;
+	if (startBatchedReceive(localIpAddress))
+		return;
+	m_pUDPServerSocket = new QUdpSocket(this);
+	QHostAddress addr(localIpAddress);
+	if (!m_pUDPServerSocket->bind(addr, 0, QUdpSocket::ShareAddress|QUdpSocket::ReuseAddressHint))
+		qDebug() << "LiveView socket not bound: " << m_pUDPServerSocket->errorString();
+	m_pUDPServerSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, RECEIVE_BUFFER_SIZE);
+	m_LocalPort = m_pUDPServerSocket->localPort();
+	connect(m_pUDPServerSocket, &QUdpSocket::readyRead, this, &CLiveViewReceiver::udpReadyRead);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CLiveViewReceiver::stop() {
+	if (m_SocketFd >= 0 || m_pUDPServerSocket != nullptr)
+		logStatistics();
+	stopBatchedReceive();
+	m_LocalPort = 0;
+	if (m_pUDPServerSocket == nullptr)
+		return;
+	disconnect(m_pUDPServerSocket, &QUdpSocket::readyRead, this, &CLiveViewReceiver::udpReadyRead);
+	delete m_pUDPServerSocket;
+	m_pUDPServerSocket = nullptr;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewReceiver::setRecorder(CLiveViewRecorder * pRecorder) {
+	m_pRTPDatagramHandler->setRecorder(pRecorder);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CLiveViewReceiver::setLiveViewQuality(int quality) {
+	m_pRTPDatagramHandler->setLiveViewQuality((ELiveViewQuality)quality);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CLiveViewReceiver::processDatagram(const QByteArray & data) {
+	m_pRTPDatagramHandler->processDatagram(data);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CLiveViewReceiver::setBatchSize(int batchSize) {
+	m_BatchSize = (batchSize > 0) ? (unsigned int)batchSize : 1;
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CLiveViewReceiver::udpReadyRead() {
+	OLYCAMERARC_TRACE_SCOPE("udpReadyRead");
+	// This slot gets called every time a datagram is in the buffer of QUdpSocket.
+	while (m_pUDPServerSocket != nullptr && m_pUDPServerSocket->hasPendingDatagrams()) {
+		QNetworkDatagram datagram = m_pUDPServerSocket->receiveDatagram();
+		m_ReceiveCalls++;
+		m_ReceivedDatagrams++;
+		m_pRTPDatagramHandler->processDatagram(datagram.data());
+		}
+}
+
+// -----------------------------------------------------------------------
+// Creates a non-blocking UDP socket for recvmmsg(), returns false if not
+// available, then QUdpSocket is used.
+bool CLiveViewReceiver::startBatchedReceive(const QString & localIpAddress) {
+#if defined(OLYCAMERARC_RECVMMSG)
+	sockaddr_in addr = {};
+	addr.sin_family  = AF_INET;
+	addr.sin_port    = 0;
+	if (inet_pton(AF_INET, localIpAddress.toLatin1().constData(), &addr.sin_addr) != 1)
+		return false;
+
+	int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return false;
+	int reuse = 1, bufferSize = RECEIVE_BUFFER_SIZE;
+	::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize)); // Limited by net.core.rmem_max
+	socklen_t addrLen = sizeof(addr);
+	if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::getsockname(fd, (sockaddr*)&addr, &addrLen) != 0) {
+		qDebug("LiveView socket not bound: %s", strerror(errno));
+		::close(fd);
+		return false;
+		}
+
+	// Preallocated buffers, one slot of MAX_DATAGRAM_SIZE per datagram of a batch
+	m_ReceiveBuffer.resize(m_BatchSize * CRTPDatagramHandler::MAX_DATAGRAM_SIZE);
+	m_IOVectors.resize(m_BatchSize);
+	m_Messages.resize(m_BatchSize);
+	for (unsigned int i = 0; i < m_BatchSize; i++) {
+		m_IOVectors[i].iov_base = m_ReceiveBuffer.data() + i * CRTPDatagramHandler::MAX_DATAGRAM_SIZE;
+		m_IOVectors[i].iov_len  = CRTPDatagramHandler::MAX_DATAGRAM_SIZE;
+		m_Messages[i] = mmsghdr();
+		m_Messages[i].msg_hdr.msg_iov    = &m_IOVectors[i];
+		m_Messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+	m_SocketFd        = fd;
+	m_LocalPort       = ntohs(addr.sin_port);
+	m_pSocketNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+	connect(m_pSocketNotifier, SIGNAL(activated(int)), this, SLOT(socketActivated()));
+	return true;
+#else
+	Q_UNUSED(localIpAddress)
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewReceiver::stopBatchedReceive() {
+#if defined(OLYCAMERARC_RECVMMSG)
+	if (m_SocketFd < 0)
+		return;
+	delete m_pSocketNotifier;
+	::close(m_SocketFd);
+	m_pSocketNotifier = nullptr;
+	m_SocketFd        = -1;
+#endif
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: drains the socket, up to m_BatchSize datagrams per system call
+void CLiveViewReceiver::socketActivated() {
+#if defined(OLYCAMERARC_RECVMMSG)
+	OLYCAMERARC_TRACE_SCOPE("socketActivated");
+	const unsigned int batchSize = m_Messages.size();
+	int count = batchSize;
+	while (m_SocketFd >= 0 && count == (int)batchSize) {
+		count = ::recvmmsg(m_SocketFd, m_Messages.data(), batchSize, MSG_DONTWAIT, nullptr);
+		m_ReceiveCalls++;
+		if (count <= 0) {
+			if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				qDebug("LiveView recvmmsg failed: %s", strerror(errno));
+			break;
+			}
+		m_ReceivedDatagrams += count;
+		for (int i = 0; i < count; i++) {
+			if ((m_Messages[i].msg_hdr.msg_flags & MSG_TRUNC) == 0)
+				m_pRTPDatagramHandler->processDatagram((const u_int8_t*)m_IOVectors[i].iov_base, m_Messages[i].msg_len);
+			}
+		}
+#endif
+}
+
+}}} // End namespaces
@@ -0,0 +1,139 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_LIVEVIEWRECEIVER_H
+#define DE_BSWALZ_OLYCAMERARC_LIVEVIEWRECEIVER_H
+
+/**
+ * OlympusCamera-RemoteControl: receiver of LiveView datagrams
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "types.h"
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <vector>
+#include <common/mvc/View.h>		// Separate git-repo
+
+#if defined(Q_OS_LINUX)
+#define OLYCAMERARC_RECVMMSG		// Batched receive of datagrams with recvmmsg()
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+class QUdpSocket;
+class QSocketNotifier;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+using de::bswalz::mvc::View;
+using de::bswalz::mvc::Model;
+
+class CQMLBackend;
+class CRTPDatagramHandler;
+class CFrameBuffer;
+class CLiveViewRecorder;
+
+// -----------------------------------------------------------------------
+// Class CLiveViewReceiver
+// Owns the UDP socket and the RTP reassembly. Lives in its own thread,
+// only complete LiveView images are published to the GUI.
+// On Linux the datagrams are received in batches by recvmmsg() into
+// preallocated buffers, otherwise by QUdpSocket.
+// -----------------------------------------------------------------------
+class CLiveViewReceiver : public QObject, public View {
+	Q_OBJECT
+public:
+	static const unsigned int DEFAULT_BATCH_SIZE   = 32;			// Datagrams per recvmmsg()
+	static const int          RECEIVE_BUFFER_SIZE  = 1024 * 1024;	// SO_RCVBUF
+	static const quint64      STATISTICS_LOG_INTERVAL = 500;		// Frames
+
+	CLiveViewReceiver(CQMLBackend * pQMLBackend);
+	virtual ~CLiveViewReceiver();
+
+	/** Inherited from View */
+	virtual void update(const Model * pModel, void * pObject) override;
+
+	/** Local UDP port, 0 if not bound. May be called from any thread. */
+	quint16	getLocalPort() const { return m_LocalPort; }
+	/** Statistics, may be called from any thread */
+	quint64	getReceiveCalls() const { return m_ReceiveCalls; }
+	quint64	getReceivedDatagrams() const { return m_ReceivedDatagrams; }
+	quint64	getReceivedFrames() const { return m_ReceivedFrames; }
+	/** RTP packets received resp. lost, see CRTPStatistics */
+	quint64	getReceivedPackets() const { return m_ReceivedPackets; }
+	quint64	getLostPackets() const { return m_LostPackets; }
+	double	getReceiveCallsPerFrame() const;
+	/** Latest LiveView frame, see CRTPDatagramHandler::takeFrame(). May be called from any thread. */
+	CFrameBuffer * takeFrame();
+	void	releaseFrame(CFrameBuffer *);
+	/** Records the complete frames, see CRTPDatagramHandler::setRecorder(). May be called from any thread. */
+	void	setRecorder(CLiveViewRecorder *);
+
+public slots:
+	/** Binds the UDP socket to the local address */
+	void	start(const QString & localIpAddress);
+	/** Closes the UDP socket */
+	void	stop();
+	/** Adapts the frame buffers to the negotiated "lvqty" (ELiveViewQuality) */
+	void	setLiveViewQuality(int);
+	/** Processes a datagram received by another source */
+	void	processDatagram(const QByteArray &);
+	/** Number of datagrams received by one recvmmsg(), applied on next start() */
+	void	setBatchSize(int);
+
+protected slots:
+	void	udpReadyRead();
+	void	socketActivated();
+
+private:
+	bool	startBatchedReceive(const QString & localIpAddress);
+	void	stopBatchedReceive();
+	void	logStatistics();
+
+	CQMLBackend *			m_pQMLBackend;
+	QUdpSocket *			m_pUDPServerSocket;
+	CRTPDatagramHandler *	m_pRTPDatagramHandler;
+	std::atomic<quint16>	m_LocalPort;
+	std::atomic<quint64>	m_ReceiveCalls;
+	std::atomic<quint64>	m_ReceivedDatagrams;
+	std::atomic<quint64>	m_ReceivedFrames;
+	std::atomic<quint64>	m_ReceivedPackets;
+	std::atomic<quint64>	m_LostPackets;
+	quint64					m_NextStatisticsLog;
+	unsigned int			m_BatchSize;
+	int						m_SocketFd;
+	QSocketNotifier *		m_pSocketNotifier;
+#if defined(OLYCAMERARC_RECVMMSG)
+	std::vector<u_int8_t>	m_ReceiveBuffer;
+	std::vector<iovec>		m_IOVectors;
+	std::vector<mmsghdr>	m_Messages;
+#endif
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_LIVEVIEWRECEIVER_H
@@ -0,0 +1,407 @@
+/**
+ * OlympusCamera-RemoteControl: recording of LiveView to MJPEG AVI
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "liveviewrecorder.h"
+#include <QtGlobal>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+const uint32_t AVIF_HASINDEX  = 0x10;
+const uint32_t AVIIF_KEYFRAME = 0x10;
+const int      HEADER_SIZE    = 212;	// RIFF, hdrl with avih, strl with strh and strf
+const u_int8_t ZEROS[CLiveViewRecorder::BLOCK_SIZE] = {};
+
+// Little endian
+void put16(u_int8_t * p, uint16_t value) { p[0] = (u_int8_t)value; p[1] = (u_int8_t)(value >> 8); }
+void put32(u_int8_t * p, uint32_t value) { put16(p, (uint16_t)value); put16(p + 2, (uint16_t)(value >> 16)); }
+void putId(u_int8_t * p, const char * id) { memcpy(p, id, 4); }
+}
+
+// -----------------------------------------------------------------------
+// Class CLiveViewRecorder
+// -----------------------------------------------------------------------
+CLiveViewRecorder::CLiveViewRecorder()
+	: m_RingHead(0), m_RingUsed(0), m_StopRequested(false), m_Width(0), m_Height(0), m_Recording(false),
+	  m_RecordedFrames(0), m_DroppedFrames(0), m_RingTail(0), m_Segment(0), m_SegmentWidth(0), m_SegmentHeight(0),
+	  m_Fd(-1), m_WriteError(false), m_pHeader(nullptr), m_pBuffer(nullptr), m_BufferSize(0), m_FileOffset(0),
+	  m_pIndexFile(nullptr), m_SegmentFrames(0), m_MaxFrameSize(0), m_FirstTime(0), m_LastTime(0), m_MoviEnd(0) {
+	// Intentionally left blank
+}
+
+// -----------------------------------------------------------------------
+CLiveViewRecorder::~CLiveViewRecorder() {
+	stop();
+}
+
+// -----------------------------------------------------------------------
+bool CLiveViewRecorder::start(const std::string & fileName, int width, int height) {
+	stop();
+	void * pHeader = nullptr;
+	void * pBuffer = nullptr;
+	m_Error.clear();
+	if (posix_memalign(&pHeader, BLOCK_SIZE, BLOCK_SIZE) != 0 || posix_memalign(&pBuffer, BLOCK_SIZE, WRITE_SIZE) != 0) {
+		free(pHeader);
+		m_Error = "Out of memory";
+		return false;
+		}
+	m_pHeader        = (u_int8_t*)pHeader;
+	m_pBuffer        = (u_int8_t*)pBuffer;
+	m_FileName       = fileName;
+	m_Segment        = 0;
+	m_WriteError     = false;
+	m_RecordedFrames = 0;
+	m_DroppedFrames  = 0;
+	m_Ring.resize(RING_SIZE);	// Once per recording
+	m_RingHead       = 0;
+	m_RingTail       = 0;
+	m_RingUsed       = 0;
+	m_StopRequested  = false;
+	m_Width          = width;
+	m_Height         = height;
+	m_Frames.clear();
+	if (!openSegment(width, height)) {
+		free(m_pHeader);
+		free(m_pBuffer);
+		m_pHeader = m_pBuffer = nullptr;
+		std::vector<u_int8_t>().swap(m_Ring);
+		return false;
+		}
+	m_Recording = true;
+	m_Writer    = std::thread(&CLiveViewRecorder::writerLoop, this);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewRecorder::stop() {
+	{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_Recording)
+		return;
+	m_Recording     = false;	// addFrame() copies under the lock: no producer is left in the ring
+	m_StopRequested = true;
+	}
+	m_Condition.notify_one();
+	m_Writer.join();
+	free(m_pHeader);
+	free(m_pBuffer);
+	m_pHeader = m_pBuffer = nullptr;
+	std::vector<u_int8_t>().swap(m_Ring);
+	qDebug("LiveView recording: %llu frames, %llu dropped", (unsigned long long)m_RecordedFrames, (unsigned long long)m_DroppedFrames);
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewRecorder::setFrameSize(int width, int height) {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Width  = width;
+	m_Height = height;
+}
+
+// -----------------------------------------------------------------------
+// Invoked by the receiver thread. Never waits for the writer thread: the
+// lock is held by it for a few instructions only.
+void CLiveViewRecorder::addFrame(const u_int8_t * pData, int size, int64_t time) {
+	if (!m_Recording || size <= 0)
+		return;
+	{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_Recording)
+		return;
+	if (m_RingUsed + size > m_Ring.size() || m_Frames.size() >= (size_t)MAX_QUEUED_FRAMES) {
+		m_DroppedFrames++;
+		return;
+		}
+	const size_t first = (m_RingHead + size <= m_Ring.size()) ? size : m_Ring.size() - m_RingHead;
+	memcpy(&m_Ring[m_RingHead], pData, first);
+	memcpy(&m_Ring[0], pData + first, size - first);
+	m_RingHead  = (m_RingHead + size) % m_Ring.size();
+	m_RingUsed += size;
+	m_Frames.push_back(CFrame(size, time));
+	}
+	m_Condition.notify_one();
+}
+
+// -----------------------------------------------------------------------
+// The queued frames are written before stopping
+void CLiveViewRecorder::writerLoop() {
+	while (true) {
+		CFrame frame;
+		int width, height;
+		{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this] { return !m_Frames.empty() || m_StopRequested; });
+		if (m_Frames.empty())
+			break;
+		frame  = m_Frames.front();
+		width  = m_Width;
+		height = m_Height;
+		m_Frames.pop_front();
+		}
+		// Chunk, "idx1" and "otms" entries of the frame and the following ones have to fit
+		const int64_t segmentSize = m_FileOffset + (int64_t)m_BufferSize + 8 + frame.size + 1 + 24LL * (m_SegmentFrames + 1) + 2 * BLOCK_SIZE;
+		if (!m_WriteError && (width != m_SegmentWidth || height != m_SegmentHeight || segmentSize > MAX_SEGMENT_SIZE)) {
+			closeSegment();
+			openSegment(width, height);
+			}
+		writeFrame(frame);
+		}
+	closeSegment();
+}
+
+// -----------------------------------------------------------------------
+std::string CLiveViewRecorder::getSegmentName() const {
+	if (m_Segment <= 1)
+		return m_FileName;
+	const size_t dot = m_FileName.rfind('.');
+	char suffix[16];
+	snprintf(suffix, sizeof(suffix), "_%03d", m_Segment);
+	return (dot == std::string::npos) ? m_FileName + suffix : m_FileName.substr(0, dot) + suffix + m_FileName.substr(dot);
+}
+
+// -----------------------------------------------------------------------
+// Opens the next file and writes the placeholder of the header
+bool CLiveViewRecorder::openSegment(int width, int height) {
+	m_Segment++;
+	const std::string fileName = getSegmentName();
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(O_DIRECT)
+	m_Fd = open(fileName.c_str(), flags | O_DIRECT, 0644);
+	if (m_Fd < 0 && errno == EINVAL) // Not supported by the file system (e.g. tmpfs)
+#endif
+	m_Fd = open(fileName.c_str(), flags, 0644);
+	if (m_Fd < 0) {
+		m_Error = fileName + " can't be opened: " + strerror(errno);
+		qDebug("LiveView recording: %s", m_Error.c_str());
+		m_WriteError = true;
+		return false;
+		}
+	m_pIndexFile = fopen((fileName + ".idx").c_str(), "w+b");
+	if (m_pIndexFile == nullptr) {
+		m_Error = fileName + ".idx can't be opened: " + strerror(errno);
+		qDebug("LiveView recording: %s", m_Error.c_str());
+		close(m_Fd);
+		m_Fd         = -1;
+		m_WriteError = true;
+		return false;
+		}
+	m_SegmentWidth  = width;
+	m_SegmentHeight = height;
+	m_SegmentFrames = 0;
+	m_MaxFrameSize  = 0;
+	m_FirstTime     = 0;
+	m_LastTime      = 0;
+	m_FileOffset    = 0;
+	m_BufferSize    = 0;
+	m_MoviEnd       = 0;
+	buildHeader();
+	append(m_pHeader, BLOCK_SIZE);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// The data of the frame is taken from the ring buffer
+void CLiveViewRecorder::writeFrame(const CFrame & frame) {
+	if (!m_WriteError) {
+		const int64_t position = m_FileOffset + (int64_t)m_BufferSize;
+		CIndexEntry entry;
+		entry.offset = (uint32_t)(position - (BLOCK_SIZE - 4));
+		entry.size   = (uint32_t)frame.size;
+		entry.time   = frame.time;
+		appendChunkHeader("00dc", (uint32_t)frame.size);
+		const size_t first = (m_RingTail + frame.size <= m_Ring.size()) ? frame.size : m_Ring.size() - m_RingTail;
+		append(&m_Ring[m_RingTail], first);
+		append(&m_Ring[0], frame.size - first);
+		if (frame.size & 1)
+			append("", 1);
+		if (fwrite(&entry, sizeof(entry), 1, m_pIndexFile) != 1)
+			m_WriteError = true;
+		if (m_SegmentFrames == 0)
+			m_FirstTime = frame.time;
+		m_LastTime = frame.time;
+		m_SegmentFrames++;
+		if ((uint32_t)frame.size > m_MaxFrameSize)
+			m_MaxFrameSize = (uint32_t)frame.size;
+		m_RecordedFrames++;
+		}
+	else {
+		m_DroppedFrames++;
+		}
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_RingTail  = (m_RingTail + frame.size) % m_Ring.size();
+	m_RingUsed -= frame.size;
+}
+
+// -----------------------------------------------------------------------
+// Copies into the aligned buffer, full buffers are written
+void CLiveViewRecorder::append(const void * pData, size_t size) {
+	const u_int8_t * p = (const u_int8_t*)pData;
+	while (size > 0) {
+		const size_t length = (m_BufferSize + size <= (size_t)WRITE_SIZE) ? size : WRITE_SIZE - m_BufferSize;
+		memcpy(m_pBuffer + m_BufferSize, p, length);
+		m_BufferSize += length;
+		p            += length;
+		size         -= length;
+		if (m_BufferSize == (size_t)WRITE_SIZE)
+			writeOut();
+		}
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewRecorder::appendChunkHeader(const char * id, uint32_t size) {
+	u_int8_t header[8];
+	putId(header, id);
+	put32(header + 4, size);
+	append(header, sizeof(header));
+}
+
+// -----------------------------------------------------------------------
+// Writes the buffer, its size is a multiple of BLOCK_SIZE
+void CLiveViewRecorder::writeOut() {
+	size_t written = 0;
+	while (!m_WriteError && written < m_BufferSize) {
+		const ssize_t result = pwrite(m_Fd, m_pBuffer + written, m_BufferSize - written, m_FileOffset + written);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0) {
+			qDebug("LiveView recording: write error %s", strerror(errno));
+			m_WriteError = true;
+			}
+		else {
+			written += result;
+			}
+		}
+	m_FileOffset += m_BufferSize;
+	m_BufferSize  = 0;
+}
+
+// -----------------------------------------------------------------------
+// Appends "idx1", "otms" and a "JUNK" chunk up to the next block boundary,
+// then rewrites the header
+void CLiveViewRecorder::closeSegment() {
+	if (m_Fd < 0)
+		return;
+	const std::string fileName = getSegmentName();
+	m_MoviEnd = m_FileOffset + (int64_t)m_BufferSize;
+
+	CIndexEntry entry;
+	u_int8_t    record[16];
+	appendChunkHeader("idx1", 16 * m_SegmentFrames);
+	rewind(m_pIndexFile);
+	for (uint32_t i = 0; i < m_SegmentFrames && fread(&entry, sizeof(entry), 1, m_pIndexFile) == 1; i++) {
+		putId(record, "00dc");
+		put32(record + 4, AVIIF_KEYFRAME);
+		put32(record + 8, entry.offset);
+		put32(record + 12, entry.size);
+		append(record, 16);
+		}
+	appendChunkHeader("otms", 8 * m_SegmentFrames);
+	rewind(m_pIndexFile);
+	for (uint32_t i = 0; i < m_SegmentFrames && fread(&entry, sizeof(entry), 1, m_pIndexFile) == 1; i++) {
+		const uint64_t time = (uint64_t)(entry.time - m_FirstTime);
+		put32(record, (uint32_t)time);
+		put32(record + 4, (uint32_t)(time >> 32));
+		append(record, 8);
+		}
+	fclose(m_pIndexFile);
+	m_pIndexFile = nullptr;
+	remove((fileName + ".idx").c_str());
+
+	int padding = BLOCK_SIZE - (int)((m_FileOffset + (int64_t)m_BufferSize) % BLOCK_SIZE);
+	if (padding < 8)
+		padding += BLOCK_SIZE;
+	if (padding != BLOCK_SIZE) {
+		appendChunkHeader("JUNK", padding - 8);
+		for (int size = padding - 8; size > 0; size -= BLOCK_SIZE)
+			append(ZEROS, (size < BLOCK_SIZE) ? size : BLOCK_SIZE);
+		}
+	writeOut();
+
+	buildHeader();
+	if (!m_WriteError && pwrite(m_Fd, m_pHeader, BLOCK_SIZE, 0) != BLOCK_SIZE)
+		m_WriteError = true;
+	close(m_Fd);
+	m_Fd = -1;
+	if (m_SegmentFrames == 0)
+		remove(fileName.c_str());
+	else
+		qDebug("LiveView recording: %s, %u frames", fileName.c_str(), m_SegmentFrames);
+}
+
+// -----------------------------------------------------------------------
+// Header block: RIFF "AVI ", LIST "hdrl", JUNK, LIST "movi" ending at
+// BLOCK_SIZE. The values not yet known are 0 before closeSegment().
+void CLiveViewRecorder::buildHeader() {
+	u_int8_t * p = m_pHeader;
+	memset(p, 0, BLOCK_SIZE);
+	const uint32_t frames     = m_SegmentFrames;
+	const uint32_t usPerFrame = (frames > 1 && m_LastTime > m_FirstTime) ? (uint32_t)((m_LastTime - m_FirstTime) / 1000 / (frames - 1)) : 33333;
+	const int64_t  fileSize   = m_FileOffset;
+	const int64_t  moviSize   = m_MoviEnd - (BLOCK_SIZE - 4);
+	const uint32_t bufferSize = m_MaxFrameSize + 8;
+
+	putId(p +   0, "RIFF"); put32(p +   4, (fileSize > 8) ? (uint32_t)(fileSize - 8) : 0); putId(p +   8, "AVI ");
+	putId(p +  12, "LIST"); put32(p +  16, HEADER_SIZE - 20);  putId(p +  20, "hdrl");
+	putId(p +  24, "avih"); put32(p +  28, 56);
+	put32(p +  32, usPerFrame);
+	put32(p +  36, usPerFrame > 0 ? (uint32_t)((uint64_t)bufferSize * 1000000 / usPerFrame) : 0);	// Max. bytes/s
+	put32(p +  44, AVIF_HASINDEX);
+	put32(p +  48, frames);
+	put32(p +  56, 1);						// Streams
+	put32(p +  60, bufferSize);
+	put32(p +  64, (uint32_t)m_SegmentWidth);
+	put32(p +  68, (uint32_t)m_SegmentHeight);
+	putId(p +  88, "LIST"); put32(p +  92, HEADER_SIZE - 96);  putId(p +  96, "strl");
+	putId(p + 100, "strh"); put32(p + 104, 56);
+	putId(p + 108, "vids"); putId(p + 112, "MJPG");
+	put32(p + 128, usPerFrame);				// Scale
+	put32(p + 132, 1000000);				// Rate
+	put32(p + 140, frames);					// Length
+	put32(p + 144, bufferSize);
+	put32(p + 148, 0xFFFFFFFF);				// Quality
+	put16(p + 160, (uint16_t)m_SegmentWidth);
+	put16(p + 162, (uint16_t)m_SegmentHeight);
+	putId(p + 164, "strf"); put32(p + 168, 40);
+	put32(p + 172, 40);
+	put32(p + 176, (uint32_t)m_SegmentWidth);
+	put32(p + 180, (uint32_t)m_SegmentHeight);
+	put16(p + 184, 1);						// Planes
+	put16(p + 186, 24);						// Bits per pixel
+	putId(p + 188, "MJPG");
+	put32(p + 192, (uint32_t)(m_SegmentWidth * m_SegmentHeight * 3));
+	putId(p + HEADER_SIZE, "JUNK"); put32(p + HEADER_SIZE + 4, BLOCK_SIZE - 12 - HEADER_SIZE - 8);
+	putId(p + BLOCK_SIZE - 12, "LIST"); put32(p + BLOCK_SIZE - 8, (moviSize > 0) ? (uint32_t)moviSize : 4); putId(p + BLOCK_SIZE - 4, "movi");
+}
+
+}}} // End namespaces
@@ -0,0 +1,150 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_LIVEVIEWRECORDER_H
+#define DE_BSWALZ_OLYCAMERARC_LIVEVIEWRECORDER_H
+
+/**
+ * OlympusCamera-RemoteControl: recording of LiveView to MJPEG AVI
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLiveViewRecorder
+// Records the LiveView JPEGs as they arrive, without re-encoding, to an
+// MJPEG AVI file. addFrame() copies a frame into a ring buffer of fixed
+// size and returns at once: if the ring is full, the frame is dropped, the
+// receive path never waits for the disk. A writer thread builds the AVI
+// chunks in an aligned buffer and writes whole blocks only (O_DIRECT where
+// available). The header occupies the first block, it is rewritten when a
+// file is closed. The index entries of a file are kept in a temporary file,
+// so the memory does not grow with the length of the recording.
+// Besides "idx1" each file has a chunk "otms" with the arrival time of
+// each frame (int64, ns since the first frame), players skip it.
+// A file is continued by "<name>_002.avi" ... at MAX_SEGMENT_SIZE or when
+// the frame size changes.
+// -----------------------------------------------------------------------
+class CLiveViewRecorder {
+public:
+	static const int     BLOCK_SIZE        = 4096;					// Alignment of the writes
+	static const int     WRITE_SIZE        = 256 * 1024;			// Bytes per write, multiple of BLOCK_SIZE
+	static const int     RING_SIZE         = 8 * 1024 * 1024;		// Bytes of the frames not yet written
+	static const int     MAX_QUEUED_FRAMES = 256;
+	static const int64_t MAX_SEGMENT_SIZE  = 1024LL * 1024 * 1024;	// Bytes per file
+
+	CLiveViewRecorder();
+	~CLiveViewRecorder();
+
+	/** Starts the writer thread, fileName e.g. "LiveView.avi". On failure see getError(). */
+	bool	start(const std::string & fileName, int width, int height);
+	/** Reason of the last failed start() */
+	const std::string & getError() const { return m_Error; }
+	/** Writes the queued frames, closes the file and stops the writer thread */
+	void	stop();
+	bool	isRecording() const { return m_Recording; }
+	/** Size of the following frames, a new file is started */
+	void	setFrameSize(int width, int height);
+	/** Copies a complete JPEG, time: arrival (CLatencyClock). May be called from any thread. */
+	void	addFrame(const u_int8_t * pData, int size, int64_t time);
+
+	uint64_t getRecordedFrames() const { return m_RecordedFrames; }
+	uint64_t getDroppedFrames() const { return m_DroppedFrames; }
+
+private:
+	class CFrame {
+	public:
+		CFrame(int s = 0, int64_t t = 0) : size(s), time(t) {}
+		int		size;
+		int64_t	time;
+	};
+	// Record of the temporary index file
+	struct CIndexEntry {
+		uint32_t	offset;		// Of the chunk, relative to "movi"
+		uint32_t	size;
+		int64_t		time;
+	};
+
+	void	writerLoop();
+	bool	openSegment(int width, int height);
+	void	closeSegment();
+	void	writeFrame(const CFrame &);
+	void	append(const void *, size_t);
+	void	appendChunkHeader(const char * id, uint32_t size);
+	void	writeOut();
+	void	buildHeader();
+	std::string getSegmentName() const;
+
+	// Shared by the producer and the writer thread, guarded by m_Mutex
+	std::mutex				m_Mutex;
+	std::condition_variable	m_Condition;
+	std::deque<CFrame>		m_Frames;
+	std::vector<u_int8_t>	m_Ring;
+	size_t					m_RingHead;		// Producer
+	size_t					m_RingUsed;
+	bool					m_StopRequested;
+	int						m_Width;
+	int						m_Height;
+	std::atomic<bool>		m_Recording;
+	std::atomic<uint64_t>	m_RecordedFrames;
+	std::atomic<uint64_t>	m_DroppedFrames;
+	std::thread				m_Writer;
+
+	// Writer thread
+	std::string				m_FileName;
+	size_t					m_RingTail;
+	int						m_Segment;		// 1, 2, ...
+	int						m_SegmentWidth;
+	int						m_SegmentHeight;
+	int						m_Fd;
+	bool					m_WriteError;
+	std::string				m_Error;
+	u_int8_t *				m_pHeader;		// BLOCK_SIZE, aligned
+	u_int8_t *				m_pBuffer;		// WRITE_SIZE, aligned
+	size_t					m_BufferSize;	// Used
+	int64_t					m_FileOffset;	// Written
+	std::FILE *				m_pIndexFile;
+	uint32_t				m_SegmentFrames;
+	uint32_t				m_MaxFrameSize;
+	int64_t					m_FirstTime;
+	int64_t					m_LastTime;
+	int64_t					m_MoviEnd;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_LIVEVIEWRECORDER_H
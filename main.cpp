@@ -29,18 +29,27 @@
 
 #include "main.h"
 #include "mainwindow.h"
+#include "liveviewreceiver.h"
+#include "rtpdatagramhandler.h"
+#include "networkmonitor.h"
+#include "capturesequencer.h"
+#include "triggerscheduler.h"
+#include "imagelibrary.h"
+#include "tracing.h"
 
-#include <common/network/networkhelper.h> // Separate git-repo
 #include <common/model/EnumParameter.h>   // Separate git-repo
 #include <common/model/Parameter.h>		  // Separate git-repo
 
 #include <QGuiApplication>
 #include <QApplication>
-#include <QRunnable>
 #include <QLocale>
 #include <QTranslator>
-#include <QRunnable>
-#include <QThreadPool>
+#include <QThread>
+#include <QTimer>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include <QUrl>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QPushButton>
@@ -52,10 +61,9 @@
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QTcpServer>
-#include <QtNetwork/QUdpSocket>
-#include <QtNetwork/QNetworkDatagram>
 #include <QMessageBox>
 
+#if !defined(OLYCAMERARC_NO_MAIN) // Defined by tools linking the application's classes, e.g. the benchmark
 int main(int argc, char *argv[])
 {
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -85,24 +93,10 @@ int main(int argc, char *argv[])
     mainWindow.show();
 	return app.exec();
 }
+#endif
 
 namespace de { namespace bswalz { namespace olycamerarc {
 namespace {
-// -----------------------------------------------------------------------
-// Anonymous class CNetworkObserver
-// -----------------------------------------------------------------------
-class CNetworkObserver : public QRunnable {
-public:
-	CNetworkObserver(CMainController * pMainController)
-			: QRunnable(), m_pOwner(pMainController), m_StopRequest(false) {}
-	virtual ~CNetworkObserver() {}
-	virtual void run() override;
-	void    stopRequest() { m_StopRequest = true; }
-private:
-	CMainController * m_pOwner;
-	bool              m_StopRequest;
-};
-
 // -----------------------------------------------------------------------
 // Anonymous debugging function
 // -----------------------------------------------------------------------
@@ -119,6 +113,7 @@ class CInitState : public CMainStateMachine::IState {
 public:
 	static CInitState * getInstance();
 	virtual void pressFocusButton(CMainStateMachine * pSource) override;
+	virtual void startSequence(CMainStateMachine * pSource) override;
 	virtual void commandsProcessed(CMainStateMachine * pSource, EOlyCommands) override;
 	virtual void tearDown(CMainStateMachine * pSource) override;
 	void		 init(CMainStateMachine * pSource);
@@ -152,6 +147,7 @@ public:
 	static CFocussedState * getInstance();
 	virtual void releaseFocusButton(CMainStateMachine * pSource) override;
 	virtual void pressShutterButton(CMainStateMachine * pSource) override;
+	virtual void startSequence(CMainStateMachine * pSource) override;
 	virtual void tearDown(CMainStateMachine * pSource) override;
 	virtual EState getId() const override { return Focussed; }
 private:
@@ -222,28 +218,128 @@ private:
 	static std::unique_ptr<CTriggerReleaseState> m_upInstance;
 };
 
-} // End anonymous namespace
-
 // -----------------------------------------------------------------------
-// Class CRTPDatagramHandler
+// Anonymous class CSequenceState
+// Capture sequence started in state Init or Focussed, the manual buttons
+// are ignored until the sequence has been stopped.
 // -----------------------------------------------------------------------
-class CRTPDatagramHandler : public mvc::Model {
+class CSequenceState : public CMainStateMachine::IState {
 public:
-	CRTPDatagramHandler() : mvc::Model("RTPDatagramHandler"), m_PayloadNumber(0uL) {}
-	virtual ~CRTPDatagramHandler() {}
-	void	processDatagram(const QByteArray &);
-	std::queue<QByteArray> & getPayloads() { return m_Payloads; }
+	static CSequenceState * getInstance();
+	virtual void stopSequence(CMainStateMachine * pSource) override;
+	virtual void error(CMainStateMachine * pSource) override { stopSequence(pSource); }
+	virtual void tearDown(CMainStateMachine * pSource) override;
+	virtual EState getId() const override { return Sequence; }
+	void		 enter(CMainStateMachine * pSource, CMainStateMachine::IState * pReturnState);
 private:
-	QByteArray m_PartialPayload;
-	std::queue<QByteArray> m_Payloads;
-	u_int32_t  m_PayloadNumber;
+	CSequenceState() : m_pReturnState(nullptr) {}
+	static std::unique_ptr<CSequenceState> m_upInstance;
+	CMainStateMachine::IState * m_pReturnState;
 };
 
+} // End anonymous namespace
+
 // -----------------------------------------------------------------------
 // Default Gateway of OlyCamera
 // -----------------------------------------------------------------------
 const std::string OLY_DEFAULT_GATEWAY = "192.168.0.10";
 const std::string LOCAL_HOST          = "127.0.0.1";
+// Environment variable with an alternative camera address "host[:port]", e.g. of the simulator
+const char * const CAMERA_ADDRESS_VARIABLE = "OLYCAMERARC_CAMERA_ADDRESS";
+// Environment variable with the file name of a Chrome trace, enables tracing
+const char * const TRACE_FILE_VARIABLE     = "OLYCAMERARC_TRACE";
+// Environment variable with the capture sequence "shots[:interval in ms]", interval 0: as fast as possible
+const char * const SEQUENCE_VARIABLE       = "OLYCAMERARC_SEQUENCE";
+
+// -----------------------------------------------------------------------
+// Names for tracing, index: EOlyCommands resp. EState
+// -----------------------------------------------------------------------
+const char * const OLY_COMMAND_NAMES[] = { "NoCommand", "SetRecMode", "SetShutterMode", "1stPush", "1stRelease", "2ndPush", "2ndRelease",
+										   "1st2ndPush", "2nd1stRelease", "RequestShutterSpeed", "RequestFocalValue", "RequestEVValue",
+										   "RequestISOValue", "RequestCameraDriveMode", "StartLiveView", "StopLiveView", "GetLastImage",
+										   "GetRecView", "StoreImage", "RequestCommandList", "RequestDescList", "SetPlayMode" };
+const char * const STATE_NAMES[]       = { "State Init", "State FocusRequest", "State Focussed", "State FocusRelease",
+										   "State TriggerRequest", "State Triggered", "State TriggerRelease", "State Sequence" };
+
+const int OLY_COMMAND_COUNT = EOCSetPlayMode + 1;
+
+// -----------------------------------------------------------------------
+// Parameter "lvqty" of switch_cammode.cgi, index: ELiveViewQuality
+// -----------------------------------------------------------------------
+const char * const LIVEVIEW_QUALITIES[] = { "0320x0240", "0640x0480", "0800x0600", "1024x0768", "1280x0960" };
+
+// -----------------------------------------------------------------------
+// Exposure properties shown by the GUI, "propname" of get_camprop.cgi
+// -----------------------------------------------------------------------
+const struct { const char * name; EOlyCommands cmd; } EXPOSURE_PROPERTIES[] = {
+	{ "shutspeedvalue",  EOCRequestShutterSpeed },
+	{ "focalvalue",      EOCRequestFocalValue },
+	{ "expcomp",         EOCRequestEVValue },
+	{ "isospeedvalue",   EOCRequestISOValue },
+	{ "cameradrivemode", EOCRequestCameraDriveMode } };
+
+// -----------------------------------------------------------------------
+// Implementation of class CCommandQueue
+// -----------------------------------------------------------------------
+void CCommandQueue::push(EOlyCommands cmd) {
+	if (!CMainController::isReadOnlyCommand(cmd)) {
+		m_ControlLane.push_back(cmd);
+		return;
+		}
+	for (const CEntry & entry : m_BackgroundLane) {
+		if (entry.cmd == cmd) { // Still waiting, the reply will be up to date
+			m_CoalescedCommands++;
+			return;
+			}
+		}
+	m_BackgroundLane.push_back(CEntry(cmd, CLatencyClock::now()));
+}
+
+// -----------------------------------------------------------------------
+bool CCommandQueue::empty() {
+	dropStaleCommands();
+	return m_ControlLane.empty() && m_BackgroundLane.empty();
+}
+
+// -----------------------------------------------------------------------
+EOlyCommands CCommandQueue::front() {
+	dropStaleCommands();
+	if (!m_ControlLane.empty())		return m_ControlLane.front();
+	if (!m_BackgroundLane.empty())	return m_BackgroundLane.front().cmd;
+	return EOCNoCommand;
+}
+
+// -----------------------------------------------------------------------
+void CCommandQueue::pop() {
+	if (!m_ControlLane.empty())			m_ControlLane.pop_front();
+	else if (!m_BackgroundLane.empty())	m_BackgroundLane.pop_front();
+}
+
+// -----------------------------------------------------------------------
+void CCommandQueue::clear() {
+	m_ControlLane.clear();
+	m_BackgroundLane.clear();
+}
+
+// -----------------------------------------------------------------------
+void CCommandQueue::clearBackground() {
+	m_BackgroundLane.clear();
+}
+
+// -----------------------------------------------------------------------
+// The next polling cycle requests these properties again. The command list
+// is requested once per connection only, it is never dropped.
+void CCommandQueue::dropStaleCommands() {
+	const int64_t now = CLatencyClock::now();
+	for (auto it = m_BackgroundLane.begin(); it != m_BackgroundLane.end(); ) {
+		if (now - it->enqueueTime > MAX_BACKGROUND_AGE && it->cmd != EOCRequestCommandList) {
+			it = m_BackgroundLane.erase(it);
+			m_DroppedCommands++;
+			}
+		else
+			++it;
+		}
+}
 
 // -----------------------------------------------------------------------
 // Implementation of class CMainController
@@ -263,10 +359,33 @@ void CMainController::init(QCoreApplication * pApp, QWidget * pRootWidget) {
     m_upWifiStatus.reset( new CEnumParameter("WifiStatus", EWifiNotConnected, wifi_values) );
     m_upLocalIpAddress.reset( new CAStringParameter("LocalIpAddress", LOCAL_HOST) );
 
+	OLYCAMERARC_TRACE_THREAD_NAME("GUI");
+	if (qEnvironmentVariableIsSet(TRACE_FILE_VARIABLE))
+		CTracer::setEnabled(true);
+
+	m_pCaptureSequencer     = new CCaptureSequencer(this);
+	m_pTriggerScheduler     = new CTriggerScheduler();
+	m_pTriggerThread        = new QThread();
+	m_pTriggerScheduler->moveToThread(m_pTriggerThread);
+	m_pTriggerThread->start(QThread::TimeCriticalPriority);
 	m_StateMachine.init();
 	m_StateMachine.addListener(this);
 	m_pNetworkAccessManager = new QNetworkAccessManager();
-	m_pRTPDatagramHandler   = new CRTPDatagramHandler();
+	m_pLiveViewReceiver     = new CLiveViewReceiver(&m_QMLBackend);
+	m_pLiveViewReceiver->setRecorder(&m_LiveViewRecorder);
+	m_pLiveViewThread       = new QThread();
+	m_pLiveViewReceiver->moveToThread(m_pLiveViewThread);
+	m_pLiveViewThread->start();
+	if (qEnvironmentVariableIsSet(CAMERA_ADDRESS_VARIABLE))
+		m_CameraAddress = qgetenv(CAMERA_ADDRESS_VARIABLE).toStdString();
+	qDebug("Camera address: %s", m_CameraAddress.c_str());
+	invalidateCommandRequests();
+	m_pImageLibrary         = new CImageLibrary(m_pNetworkAccessManager, this);
+	m_pImageLibrary->init(m_CameraAddress, QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails");
+	QMetaObject::invokeMethod(m_pTriggerScheduler, "setCameraAddress", Qt::QueuedConnection, Q_ARG(QString, QString::fromStdString(m_CameraAddress)));
+	m_pNetworkMonitor       = new CNetworkMonitor(m_CameraAddress.substr(0, m_CameraAddress.find(':')) /*host*/, this);
+	m_pPropertyTimer        = new QTimer(this);
+	m_pPropertyTimer->setSingleShot(true);
 
 	m_QMLBackend.init(this, pRootWidget);
 
@@ -276,36 +395,58 @@ void CMainController::init(QCoreApplication * pApp, QWidget * pRootWidget) {
     connect(this, SIGNAL(dispatchCommandListRequest()),   this, SLOT(_requestCommandList()), Qt::QueuedConnection);
     connect(this, SIGNAL(notifyWifiStatusChanged()),      this, SLOT(_notifyWifiStatusChanged()), Qt::QueuedConnection);
 	connect(this, SIGNAL(notifyCameraValueChanged(QVariant,QVariant)), pRootWidget, SLOT(notifyCameraValueChanged(QVariant,QVariant)));
+	connect(m_pNetworkMonitor, SIGNAL(networkChanged(int,QString)), this, SLOT(_networkChanged(int,QString)));
+	connect(m_pPropertyTimer,  SIGNAL(timeout()),                  this, SLOT(_pollExposureProperties()));
+	connect(m_pCaptureSequencer, SIGNAL(shotDue(qint64)), this, SLOT(_captureShotDue(qint64)));
+	connect(m_pCaptureSequencer, SIGNAL(finished()),      this, SLOT(_captureSequenceFinished()), Qt::QueuedConnection);
+	connect(m_pTriggerScheduler, SIGNAL(triggerFinished(qint64,qint64,bool)), this, SLOT(_triggerFinished(qint64,qint64,bool)), Qt::QueuedConnection);
 
 	registerAt(m_upWifiStatus.get(), true /*Notifies QML widget*/);
-    registerAt(m_pRTPDatagramHandler, false);
 
-	QThreadPool::globalInstance()->start(m_pNetworkObserver);
+	m_pNetworkMonitor->start();
 }
 
 // -----------------------------------------------------------------------
 void CMainController::tearDown() {
-	dynamic_cast<CNetworkObserver*>(m_pNetworkObserver)->stopRequest();
+	m_pNetworkMonitor->stop();
+	m_pPropertyTimer->stop();
+	m_pCaptureSequencer->abort();
 	disconnect(this, SIGNAL(dispatchExposurePropertiesRequest()), this, SLOT(_requestExposureProperties()));
 	disconnect(this, SIGNAL(dispatchLifeViewImageRequest()), this, SLOT(_requestLifeViewImage()));
     disconnect(this, SIGNAL(dispatchCommandListRequest()),   this, SLOT(_requestCommandList()));
     disconnect(this, SIGNAL(notifyWifiStatusChanged()),      this, SLOT(_notifyWifiStatusChanged()));
-	if (m_pUDPServerSocket != nullptr)
-		disconnect(((QIODevice*)m_pUDPServerSocket), SIGNAL(readyRead()), this, SLOT(udpReadyRead()));
+	QMetaObject::invokeMethod(m_pLiveViewReceiver, "stop", Qt::BlockingQueuedConnection);
+	QMetaObject::invokeMethod(m_pTriggerScheduler, "stop", Qt::BlockingQueuedConnection);
+	m_LiveViewRecorder.stop();
 	m_QMLBackend.tearDown();
 	QThread::msleep(800);
 
 	m_StateMachine.tearDown();
 
-	unregisterAt(m_pRTPDatagramHandler);
     unregisterAt(m_upWifiStatus.get());
-	if (m_pUDPServerSocket != nullptr)
-		delete m_pUDPServerSocket;
-	delete m_pRTPDatagramHandler;
-	delete m_pNetworkAccessManager;
-	m_pUDPServerSocket      = nullptr;
-	m_pRTPDatagramHandler   = nullptr;
+	m_pLiveViewThread->quit();
+	m_pLiveViewThread->wait();
+	delete m_pLiveViewReceiver;
+	delete m_pLiveViewThread;
+	m_pTriggerThread->quit();
+	m_pTriggerThread->wait();
+	delete m_pTriggerScheduler;
+	delete m_pTriggerThread;
+	m_pTriggerScheduler     = nullptr;
+	m_pTriggerThread        = nullptr;
+	m_pImageLibrary->cancel();
+	delete m_pNetworkAccessManager; // Deletes the replies in flight
+	m_NetworkReplies.clear();
+	m_StateChangingRequestPending = false;
+	m_pLiveViewReceiver     = nullptr;
+	m_pLiveViewThread       = nullptr;
 	m_pNetworkAccessManager = nullptr;
+
+	if (CTracer::isEnabled()) {
+		const std::string fileName = qgetenv(TRACE_FILE_VARIABLE).toStdString();
+		if (CTracer::exportChromeTrace(fileName))
+			qDebug("Trace written to %s", fileName.c_str());
+		}
 }
 
 // -----------------------------------------------------------------------
@@ -313,17 +454,20 @@ void CMainController::tearDown() {
 void CMainController::update(const Model * pModel, void * pObject) {
 	if (pModel == m_upWifiStatus.get())
 		updateWifiStatus();
-	else if (pModel == m_pRTPDatagramHandler) {
-		const QByteArray & image = m_pRTPDatagramHandler->getPayloads().front();
-		m_QMLBackend.lifeviewImageChanged(image);
-		m_pRTPDatagramHandler->getPayloads().pop();
-		}
 }
 
 // -----------------------------------------------------------------------
 // Inherited from View
 void CMainController::stateEntered(EState stateId) {
 	qDebug() << "State changed: " << (int)stateId;
+	if (stateId != Sequence && m_pCaptureSequencer != nullptr && m_pCaptureSequencer->isRunning()) { // Aborted by an error
+		m_pCaptureSequencer->abort();
+		qDebug("%s (aborted)", m_pCaptureSequencer->getSummary().c_str());
+		}
+	if (stateId != Sequence) {
+		m_TriggerHeld        = false;
+		m_PendingTriggerTime = 0;
+		}
 	switch (stateId) {
 		case FocusRequest :
                 enqueueLifeViewCommand(false /* stop */);
@@ -351,28 +495,38 @@ void CMainController::stateEntered(EState stateId) {
 				m_OlyCameraCommands.push(EOC2ndRelease);
 				processCameraCommand();
 				break;
+		case Sequence :
+				if (m_CombinedTrigger) { // Not focussed yet, the camera focusses on each shot
+					enqueueLifeViewCommand(false /* stop */);
+					m_OlyCameraCommands.push(EOCSetShutterMode);
+					processCameraCommand();
+					}
+				QMetaObject::invokeMethod(m_pTriggerScheduler, "warmUp", Qt::QueuedConnection);
+				break;
 		default:
 				break;
 		}
+	// No polling while focussing or triggering, faster after user interaction
+	adaptPropertyPolling(stateId == Init || stateId == FocusRelease);
 	this->getQMLBackend()->cameraStatusChanged(stateId);
 }
 
 // -----------------------------------------------------------------------
 CMainController::CMainController()
-	: QObject(), m_pNetworkObserver(nullptr), m_upWifiStatus(nullptr), m_upLocalIpAddress(nullptr),
-	  m_pNetworkAccessManager(nullptr), m_pUDPServerSocket(nullptr), m_pNetworkReply(nullptr),
-    m_pRTPDatagramHandler(nullptr), m_CameraMode(ECM_Undefined), m_ExposureMode(EEM_Undefined),
-    m_HasShutterSpeedValue(false), m_LifeViewEnabled(false), m_LifeViewPotentiallyStarted(false) {
-	CNetworkObserver * pObserver = new CNetworkObserver(this);
-	m_pNetworkObserver           = pObserver;
-	m_pNetworkObserver->setAutoDelete(true);
+	: QObject(), m_pNetworkMonitor(nullptr), m_pPropertyTimer(nullptr), m_pCaptureSequencer(nullptr), m_CombinedTrigger(false),
+	  m_pImageLibrary(nullptr), m_PlayModeEnabled(false),
+	  m_pTriggerScheduler(nullptr), m_pTriggerThread(nullptr), m_TriggerHeld(false), m_PendingTriggerTime(0),
+	  m_CommandRequests(OLY_COMMAND_COUNT), m_NextStatisticsLog(STATISTICS_LOG_INTERVAL),
+	  m_PropertyInterval(PROPERTY_INTERVAL),
+	  m_FastPolls(0), m_PropertiesChanged(false), m_upWifiStatus(nullptr), m_upLocalIpAddress(nullptr),
+	  m_pNetworkAccessManager(nullptr), m_pLiveViewThread(nullptr), m_StateChangingRequestPending(false),
+    m_pLiveViewReceiver(nullptr), m_CameraMode(ECM_Undefined), m_ExposureMode(EEM_Undefined),
+    m_HasShutterSpeedValue(false), m_HasDescList(false), m_LifeViewEnabled(false), m_LifeViewPotentiallyStarted(false), m_ButtonPressTime(0),
+    m_LiveViewQuality(ELVQ_0320x0240), m_CameraAddress(OLY_DEFAULT_GATEWAY) {
 }
 
 // -----------------------------------------------------------------------
 CMainController::~CMainController() {
-	if (m_pNetworkObserver != nullptr && !m_pNetworkObserver->autoDelete()) {
-		delete m_pNetworkObserver;
-		}
 }
 
 // -----------------------------------------------------------------------
@@ -381,12 +535,18 @@ void CMainController::updateWifiStatus() {
 	switch (status) {
 		case EWifiOlyCameraConnected :
 					qDebug("Olympus Camera Wifi found");
+					if (m_pNetworkAccessManager != nullptr) { // Opens the keep-alive connection in advance, the camera accepts slowly
+						const QUrl url = getCommandRequest(EOCRequestCommandList).url();
+						m_pNetworkAccessManager->connectToHost(url.host(), (quint16)url.port(80));
+						}
                     requestCommandList();
 					break;
 		default:	qDebug("No Wifi found");
 					m_StateMachine.init();
 					break;
 		}
+	m_ExposurePropertyValues.clear(); // The GUI has to be updated on reconnection
+	adaptPropertyPolling(true);
 	m_QMLBackend.wifiStatusChanged(QVariant((int)status));
 	emit notifyWifiStatusChanged();
 }
@@ -408,89 +568,180 @@ void CMainController::enqueueLifeViewCommand(bool start) {
 }
 
 // -----------------------------------------------------------------------
-// Processes a camera command
+// Processes the queued camera commands. Read-only requests are sent in parallel
+// (up to MAX_PARALLEL_REQUESTS, Qt reuses the keep-alive connections, which
+// are opened in advance by updateWifiStatus()). The requests are prepared
+// once per command, see getCommandRequest(). State
+// changing requests precede them (see CCommandQueue) and are sent one at a
+// time without waiting for running read-only requests, all following
+// requests wait for them.
 void CMainController::processCameraCommand() {
-	if (m_pNetworkAccessManager == nullptr || m_pNetworkReply != nullptr)
+	OLYCAMERARC_TRACE_SCOPE("processCameraCommand");
+	if (m_pNetworkAccessManager == nullptr)
 		return;
 
-	QString      url;
-	EOlyCommands cmd = (m_OlyCameraCommands.empty()) ? EOCNoCommand : m_OlyCameraCommands.front();
+	while (!m_OlyCameraCommands.empty() && !m_StateChangingRequestPending) {
+		const EOlyCommands cmd      = m_OlyCameraCommands.front();
+		const bool         readOnly = isReadOnlyCommand(cmd);
+		if (readOnly && (m_NetworkReplies.size() >= MAX_PARALLEL_REQUESTS || m_TriggerHeld))
+			break;
+		if (readOnly && isCommandInFlight(cmd)) { // Coalesces with the running request
+			m_OlyCameraCommands.pop();
+			continue;
+			}
+
+		const QNetworkRequest & request = getCommandRequest(cmd);
+		if (request.url().isEmpty())
+			break; // Not yet possible, retried by the next call
+
+		QNetworkReply * pReply = m_pNetworkAccessManager->get(request);
+		connect(pReply, SIGNAL(finished()), this, SLOT(httpFinished()));
+		connect(((QIODevice*)pReply), SIGNAL(readyRead()), this, SLOT(httpReadyRead()));
+		OLYCAMERARC_TRACE_ASYNC_BEGIN(OLY_COMMAND_NAMES[cmd], pReply);
+		CRequestInFlight & inFlight   = m_NetworkReplies[pReply];
+		inFlight.cmd                  = cmd;
+		inFlight.sendTime             = CLatencyClock::now();
+		m_StateChangingRequestPending = !readOnly;
+		m_OlyCameraCommands.pop();
+
+		if ((cmd == EOC1stPush || cmd == EOC2ndPush) && m_ButtonPressTime > 0) {
+			m_TriggerLatency.add(CLatencyClock::now() - m_ButtonPressTime);
+			m_ButtonPressTime = 0;
+			qDebug("Trigger latency: p50 %.1f ms, p95 %.1f ms, max %.1f ms (%llu)",
+				   m_TriggerLatency.getPercentile(50.0) / 1e6, m_TriggerLatency.getPercentile(95.0) / 1e6,
+				   m_TriggerLatency.getMax() / 1e6, (unsigned long long)m_TriggerLatency.getCount());
+			}
+		}
+}
+
+// -----------------------------------------------------------------------
+bool CMainController::hasPendingCommands() {
+	return !m_OlyCameraCommands.empty() || !m_NetworkReplies.empty();
+}
+
+// -----------------------------------------------------------------------
+bool CMainController::isCommandInFlight(EOlyCommands cmd) const {
+	for (const auto & reply : m_NetworkReplies)
+		if (reply.second.cmd == cmd)
+			return true;
+	return false;
+}
+
+// -----------------------------------------------------------------------
+const QNetworkRequest & CMainController::getCommandRequest(EOlyCommands cmd) {
+	QNetworkRequest & request = m_CommandRequests[cmd];
+	if (request.url().isEmpty()) {
+		const QString url = getCommandUrl(cmd);
+		if (url.isEmpty())
+			return request;
+		request.setUrl(QUrl(url));
+		request.setHeader(QNetworkRequest::UserAgentHeader, "OlympusCameraKit");
+		if (isReadOnlyCommand(cmd))
+			request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+		}
+	return request;
+}
+
+// -----------------------------------------------------------------------
+void CMainController::invalidateCommandRequests() {
+	for (QNetworkRequest & request : m_CommandRequests)
+		request = QNetworkRequest();
+}
+
+// -----------------------------------------------------------------------
+// Returns the URL of a camera command, empty if the command can't be sent (yet)
+QString CMainController::getCommandUrl(EOlyCommands cmd) const {
+	QString url;
 	switch(cmd) {
 		case EOCSetRecMode :
-					url = QString::fromLatin1("http://%1/switch_cammode.cgi?mode=rec&lvqty=0320x0240").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/switch_cammode.cgi?mode=rec&lvqty=%2").arg(QString::fromStdString(m_CameraAddress))
+																							   .arg(QLatin1String(LIVEVIEW_QUALITIES[m_LiveViewQuality]));
 					break;
 		case EOCSetShutterMode :
-					url = QString::fromLatin1("http://%1/switch_cammode.cgi?mode=shutter").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/switch_cammode.cgi?mode=shutter").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOC1stPush :
-					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=1stpush").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=1stpush").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOC1stRelease :
-					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=1strelease").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=1strelease").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOC2ndPush :
-					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=2ndpush").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=2ndpush").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOC2ndRelease :
-					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=2ndrelease").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=2ndrelease").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOC1st2ndPush :
-					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=1st2ndpush").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=1st2ndpush").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOC2nd1stRelease :
-					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=2nd1strelease").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_shutter.cgi?com=2nd1strelease").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOCRequestShutterSpeed :
-                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=shutspeedvalue ").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=shutspeedvalue ").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOCRequestFocalValue :
-					url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=focalvalue").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=focalvalue").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOCRequestEVValue :
-					url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=expcomp").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=expcomp").arg(QString::fromStdString(m_CameraAddress));
 					break;
         case EOCRequestCameraDriveMode :
-                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=cameradrivemode").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=cameradrivemode").arg(QString::fromStdString(m_CameraAddress));
 					break;
         case EOCRequestISOValue :
-                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=isospeedvalue").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=isospeedvalue").arg(QString::fromStdString(m_CameraAddress));
                     break;
         case EOCStartLiveView :
-					if (m_pUDPServerSocket != nullptr && m_pUDPServerSocket->localPort() >= 1024)
-						url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=startliveview&port=%2").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY))
-																									  .arg(m_pUDPServerSocket->localPort());
+					if (m_pLiveViewReceiver != nullptr && m_pLiveViewReceiver->getLocalPort() >= 1024)
+						url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=startliveview&port=%2").arg(QString::fromStdString(m_CameraAddress))
+																									  .arg(m_pLiveViewReceiver->getLocalPort());
 					break;
 		case EOCStopLiveView :
-					url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=stopliveview").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=stopliveview").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOCGetLastImage :
-					url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=getlastjpg").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=getlastjpg").arg(QString::fromStdString(m_CameraAddress));
 					break;
 		case EOCGetRecView :
-					url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=getrecview").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+					url = QString::fromLatin1("http://%1/exec_takemisc.cgi?com=getrecview").arg(QString::fromStdString(m_CameraAddress));
 					break;
         case EOCRequestCommandList :
-                    url = QString::fromLatin1("http://%1/get_commandlist.cgi").arg(QString::fromStdString(OLY_DEFAULT_GATEWAY));
+                    url = QString::fromLatin1("http://%1/get_commandlist.cgi").arg(QString::fromStdString(m_CameraAddress));
+                    break;
+        case EOCRequestDescList :
+                    url = QString::fromLatin1("http://%1/get_camprop.cgi?com=desc&propname=desclist").arg(QString::fromStdString(m_CameraAddress));
+                    break;
+        case EOCSetPlayMode :
+                    url = QString::fromLatin1("http://%1/switch_cammode.cgi?mode=play").arg(QString::fromStdString(m_CameraAddress));
                     break;
         default :	break;
 		} // End switch
+	return url;
+}
 
-	if (!url.isEmpty()) {
-		QNetworkRequest request(url);
-		request.setHeader(QNetworkRequest::UserAgentHeader, "OlympusCameraKit");
-		m_pNetworkReply = m_pNetworkAccessManager->get(request);
-		connect(m_pNetworkReply, SIGNAL(finished()), this, SLOT(httpFinished()));
-		connect(((QIODevice*)m_pNetworkReply), SIGNAL(readyRead()), this, SLOT(httpReadyRead()));
-		} // End if url is not empty
-	else {
-		; // Intentionally left blank
-		} // End if url is empty
+// -----------------------------------------------------------------------
+bool CMainController::isReadOnlyCommand(EOlyCommands cmd) {
+	switch (cmd) {
+		case EOCRequestShutterSpeed :
+		case EOCRequestFocalValue :
+		case EOCRequestEVValue :
+		case EOCRequestISOValue :
+		case EOCRequestCameraDriveMode :
+		case EOCRequestCommandList :
+		case EOCRequestDescList :
+					return true;
+		default :	return false;
+		}
 }
 
 // -----------------------------------------------------------------------
 // Invokes "2ndpush" at the camera to take the photo
 void CMainController::shutterButtonPressed() {
+	OLYCAMERARC_TRACE_INSTANT("Shutter button pressed");
 	qDebug("CMainController::shutterButtonPressed");
+	m_ButtonPressTime = CLatencyClock::now();
 	m_StateMachine.shutterButtonPressed();
 }
 
@@ -505,12 +756,50 @@ void CMainController::shutterButtonReleased() {
 // checked = true : invokes "1stpush" at the camera to focus the object
 // checked = false: invokes "1strelease" at the camera
 void CMainController::focusButtonClicked(bool checked) {
-	if (checked)	m_StateMachine.focusButtonPressed();
-	else			m_StateMachine.focusButtonReleased();
+	if (checked) {
+		m_ButtonPressTime = CLatencyClock::now();
+		m_StateMachine.focusButtonPressed();
+	} else
+		m_StateMachine.focusButtonReleased();
+}
+
+// -----------------------------------------------------------------------
+// checked = true : starts a capture sequence, see OLYCAMERARC_SEQUENCE. In state
+//                  Focussed the focus is kept ("2ndpush" / "2ndrelease" per shot),
+//                  in state Init the camera focusses on each shot ("1st2ndpush" /
+//                  "2nd1strelease").
+// checked = false: stops it after the shot in flight
+void CMainController::sequenceButtonClicked(bool checked) {
+	if (!checked) {
+		m_pCaptureSequencer->stop();
+		return;
+		}
+	const EState stateId = m_StateMachine.getStateId();
+	if (m_upWifiStatus->getValue() == EWifiOlyCameraConnected && (stateId == Init || stateId == Focussed)) {
+		CCaptureSettings settings;
+		if (qEnvironmentVariableIsSet(SEQUENCE_VARIABLE)) {
+			const QStringList values = QString::fromLatin1(qgetenv(SEQUENCE_VARIABLE)).split(':');
+			bool okShots = true, okInterval = true;
+			settings.shots = values.value(0).toInt(&okShots);
+			if (values.size() > 1)
+				settings.interval = values.value(1).toInt(&okInterval);
+			if (!okShots || !okInterval || values.size() > 2 || settings.shots < 1 || settings.interval < 0) {
+				qDebug("Invalid %s \"%s\", expected \"shots[:interval in ms]\"", SEQUENCE_VARIABLE, qgetenv(SEQUENCE_VARIABLE).constData());
+				m_QMLBackend.cameraStatusChanged(stateId); // Resets the button
+				return;
+				}
+			}
+		m_CombinedTrigger = (stateId == Init);
+		m_StateMachine.sequenceStarted();
+		m_pCaptureSequencer->start(settings);
+		}
+	else {
+		m_QMLBackend.cameraStatusChanged(stateId); // Resets the button
+		}
 }
 
 // -----------------------------------------------------------------------
-// Requests LifeView image, invoked by NetworkObserver
+// Requests exposure properties, invoked by the property timer
 void CMainController::requestExposureProperties() {
 	if (m_StateMachine.isRecModeAvail() && m_upWifiStatus->getValue() == EWifiOlyCameraConnected)
 		// Sends signal to GUI thread. Further processing at CMainController::_requestExposureProperties()
@@ -518,7 +807,7 @@ void CMainController::requestExposureProperties() {
 }
 
 // -----------------------------------------------------------------------
-// Requests LifeView image, invoked by NetworkObserver
+// Requests LifeView image
 void CMainController::requestLifeViewImage() {
 	// Sends signal to GUI thread. Further processing at CMainController::_requestLifeViewImage()
 	emit dispatchLifeViewImageRequest();
@@ -532,60 +821,197 @@ void CMainController::requestCommandList() {
 }
 
 // -----------------------------------------------------------------------
-// Analyses the reply of an exposure parameter request
-std::string CMainController::analyseReply(EOlyCommands cmd, const std::string & reply) {
-    int idx1 = reply.find("<value>");
-    int idx2 = reply.find("</value>");
-    std::string value;
-    if (idx1 < idx2 && idx1 != std::string::npos && idx2 != std::string::npos) {
-        value = reply.substr(idx1+7, (idx2-idx1-7)); // 7: "<value>"
-        return value;
-        }
-    else
-        return "";
+// Analyses the reply of an exposure parameter request or of "desclist"
+void CMainController::analyseEmitReply(EOlyCommands cmd, const QByteArray & reply) {
+	const int count = m_CameraProperties.parse(reply.constData(), reply.size());
+	if (cmd == EOCRequestDescList && count == 0) {
+		m_HasDescList = false; // Falls back to the single property requests
+		return;
+		}
+	for (const auto & property : EXPOSURE_PROPERTIES) {
+		if (cmd != EOCRequestDescList && cmd != property.cmd)
+			continue;
+		const CCameraProperty * pProperty = m_CameraProperties.find(property.name);
+		if (pProperty != nullptr)
+			notifyExposureProperty(property.cmd, pProperty->value);
+		}
 }
 
 // -----------------------------------------------------------------------
-// Analyses the reply of an exposure parameter request
-void CMainController::analyseEmitReply(EOlyCommands cmd, const std::string & reply) {
-    const std::string value = analyseReply(cmd, reply);
-    if (!value.empty()) {
+// Notifies the GUI of an exposure property
+void CMainController::notifyExposureProperty(EOlyCommands cmd, const std::string & value) {
+	auto it = m_ExposurePropertyValues.find(cmd);
+	if (it != m_ExposurePropertyValues.end() && it->second == value)
+		return; // Unchanged, the GUI is up to date
+	m_ExposurePropertyValues[cmd] = value;
+	m_PropertiesChanged = true;
+
+	if (cmd == EOCRequestCameraDriveMode) {
+		// Possible values: "normal", "continuous", "selftimer", "customselftimer",
+		// "livetime" (composite mode)
+		if      (value.find("normal") == 0)  m_ExposureMode = EEM_Normal;
+		else if (value.find("cont")   == 0)  m_ExposureMode = EEM_Continuous;
+		else if (value.find("self")   == 0)  m_ExposureMode = EEM_Self;
+		else if (value.find("livetime") == 0)  m_ExposureMode = EEM_Composite;
+		else                             m_ExposureMode = EEM_Undefined;
+		emit notifyCameraValueChanged(QVariant((int)cmd), QVariant((int)m_ExposureMode));
+		}
+	else if (!value.empty()) {
 		emit notifyCameraValueChanged(QVariant((int)cmd), QVariant(QString::fromStdString(value)));
 		}
 }
 
 // -----------------------------------------------------------------------
 // Analyses the reply of an command list request
-void CMainController::analyseCommandList(const std::string & reply) {
-    // Currently only the "shutspeedvalue" is evaluated
-    if (reply.find("shutspeedvalue") != std::string::npos)
+void CMainController::analyseCommandList(const QByteArray & reply) {
+    if (m_CommandList.parse(reply.constData(), reply.size()) <= 0) {
+        qDebug("Invalid command list");
+        return;
+        }
+    // Currently only "shutspeedvalue" and "desclist" of get_camprop?com=desc are evaluated
+    if (m_CommandList.hasParameter("get_camprop", "propname", "shutspeedvalue"))
         m_HasShutterSpeedValue = true;
+    if (m_CommandList.hasParameter("get_camprop", "propname", "desclist"))
+        m_HasDescList = true;
 }
 
 
 // -----------------------------------------------------------------------
 void CMainController::setLifeViewEnabled(bool enabled) {
     m_LifeViewEnabled = enabled;
+    m_LiveViewQualityController.restart(CLatencyClock::now());
     if (!enabled && m_LifeViewPotentiallyStarted) // Disables running LifeView
         m_OlyCameraCommands.push(EOCStopLiveView);
     else if (enabled && m_LifeViewPotentiallyStarted) // Enables potentially running LifeView
         m_OlyCameraCommands.push(EOCStartLiveView);
 }
 
+// -----------------------------------------------------------------------
+// Play mode for the image list and downloads, see CImageLibrary. Leaving it,
+// the property polling switches back to rec mode and restarts LiveView.
+void CMainController::setPlayModeEnabled(bool enabled) {
+	if (enabled == m_PlayModeEnabled || (enabled && m_StateMachine.getStateId() != Init))
+		return;
+	m_PlayModeEnabled = enabled;
+	if (enabled) {
+		enqueueLifeViewCommand(false /* stop */);
+		m_OlyCameraCommands.push(EOCSetPlayMode);
+		processCameraCommand();
+		}
+	else {
+		m_pImageLibrary->cancel();
+		}
+	adaptPropertyPolling(true);
+}
+
+// -----------------------------------------------------------------------
+// Takes the latest LifeView image, invoked by the GUI after notifyLifeViewImageChanged()
+bool CMainController::takeLifeViewImage(CLiveViewFrame & frame) {
+	CFrameBuffer * pFrame = (m_pLiveViewReceiver != nullptr) ? m_pLiveViewReceiver->takeFrame() : nullptr;
+	if (pFrame == nullptr)
+		return false;
+	frame.data            = pFrame->getData(); // Shared, the buffer is reused when the GUI has released it
+	frame.number          = pFrame->getNumber();
+	frame.firstPacketTime = pFrame->getFirstPacketTime();
+	frame.completeTime    = pFrame->getCompleteTime();
+	m_pLiveViewReceiver->releaseFrame(pFrame);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Invoked by the GUI for each displayed LifeView image
+void CMainController::lifeViewImageDecoded(const CLiveViewFrame & frame) {
+	m_LiveViewQualityController.addFrame(frame.completeTime, frame.decodedTime);
+	evaluateLiveViewQuality();
+}
+
+// -----------------------------------------------------------------------
+// Also invoked by the property polling: a link too bad for any complete
+// frame is evaluated as well
+void CMainController::evaluateLiveViewQuality() {
+	if (m_pLiveViewReceiver != nullptr)
+		m_LiveViewQualityController.setPacketCounters(m_pLiveViewReceiver->getReceivedPackets(), m_pLiveViewReceiver->getLostPackets());
+	m_LiveViewQualityController.evaluate(CLatencyClock::now());
+	adaptLiveViewQuality();
+}
+
+// -----------------------------------------------------------------------
+// quality < 0: adapted by m_LiveViewQualityController
+void CMainController::setLiveViewQuality(int quality) {
+	if (quality < ELVQ_0320x0240 || quality > ELVQ_1280x0960)
+		m_LiveViewQualityController.unpin();
+	else
+		m_LiveViewQualityController.pin((ELiveViewQuality)quality);
+	adaptLiveViewQuality();
+}
+
+// -----------------------------------------------------------------------
+// A new "lvqty" needs switch_cammode with stopped LiveView. It is applied in
+// state Init without pending commands, otherwise retried with the next image.
+// Not in rec mode, the next EOCSetRecMode takes it.
+void CMainController::adaptLiveViewQuality() {
+	const ELiveViewQuality quality = m_LiveViewQualityController.getQuality();
+	if (quality == m_LiveViewQuality)
+		return;
+	if (m_CameraMode == ECM_RecMode && (m_StateMachine.getStateId() != Init || hasPendingCommands()))
+		return;
+	m_LiveViewQuality = quality;
+	invalidateCommandRequests();
+	if (m_LiveViewRecorder.isRecording()) {
+		const QSize size = CRTPDatagramHandler::getFrameSize(quality);
+		m_LiveViewRecorder.setFrameSize(size.width(), size.height()); // Continued in a new file
+		}
+	if (m_CameraMode == ECM_RecMode) {
+		m_OlyCameraCommands.push(EOCStopLiveView);
+		m_OlyCameraCommands.push(EOCSetRecMode);
+		enqueueLifeViewCommand(true /* start */);
+		processCameraCommand();
+		}
+	m_LiveViewQualityController.restart(CLatencyClock::now());
+}
+
+// -----------------------------------------------------------------------
+// The frames are recorded as they arrive, also those not displayed
+bool CMainController::setLiveViewRecordingEnabled(bool enabled, QString & error) {
+	if (!enabled) {
+		m_LiveViewRecorder.stop();
+		return true;
+		}
+	const QString dir = QStandardPaths::writableLocation(QStandardPaths::MoviesLocation) + "/OlyCamera-RC";
+	QDir().mkpath(dir);
+	const QString fileName = QString("%1/LiveView_%2.avi").arg(dir, QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+	const QSize   size     = CRTPDatagramHandler::getFrameSize(m_LiveViewQuality);
+	if (!m_LiveViewRecorder.start(fileName.toStdString(), size.width(), size.height())) {
+		error = QString::fromStdString(m_LiveViewRecorder.getError());
+		return false;
+		}
+	qDebug("LiveView recording: %s", qPrintable(fileName));
+	return true;
+}
+
 // -----------------------------------------------------------------------
 // Qt slot: requests LifeView image
 void CMainController::_requestExposureProperties() {
+	if (m_PlayModeEnabled)
+		return;
+	if (m_LifeViewEnabled)
+		evaluateLiveViewQuality();
 	if (m_CameraMode != ECM_RecMode) {
 		m_OlyCameraCommands.push(EOCSetRecMode);
 		m_OlyCameraCommands.push(EOCStopLiveView); // ... from previous session possibly different port
         enqueueLifeViewCommand(true /* start */);
 		}
-    if (m_HasShutterSpeedValue)
-        m_OlyCameraCommands.push(EOCRequestShutterSpeed);
-	m_OlyCameraCommands.push(EOCRequestFocalValue);
-	m_OlyCameraCommands.push(EOCRequestEVValue);
-	m_OlyCameraCommands.push(EOCRequestISOValue);
-    m_OlyCameraCommands.push(EOCRequestCameraDriveMode);
+    if (m_HasDescList) { // All properties by one request
+        m_OlyCameraCommands.push(EOCRequestDescList);
+        }
+    else {
+        if (m_HasShutterSpeedValue)
+            m_OlyCameraCommands.push(EOCRequestShutterSpeed);
+        m_OlyCameraCommands.push(EOCRequestFocalValue);
+        m_OlyCameraCommands.push(EOCRequestEVValue);
+        m_OlyCameraCommands.push(EOCRequestISOValue);
+        m_OlyCameraCommands.push(EOCRequestCameraDriveMode);
+        }
     processCameraCommand();
 }
 
@@ -602,28 +1028,110 @@ void CMainController::_requestLifeViewImage() {
 	; // ToDo:
 }
 
+// -----------------------------------------------------------------------
+// Qt slot: result of the network monitor
+void CMainController::_networkChanged(int status, QString localIpAddress) {
+	// The address first, it is required on the change of the Wifi status
+	m_upLocalIpAddress->assignValue(localIpAddress.isEmpty() ? LOCAL_HOST : localIpAddress.toStdString());
+	m_upWifiStatus->assignValue(status);
+}
+
+// -----------------------------------------------------------------------
+// Polls fast after user interaction, then backs off exponentially as long
+// as the values do not change
+void CMainController::adaptPropertyPolling(bool accelerate) {
+	if (m_pPropertyTimer == nullptr)
+		return;
+	if (m_upWifiStatus->getValue() != EWifiOlyCameraConnected || !m_StateMachine.isRecModeAvail() || m_PlayModeEnabled) {
+		m_pPropertyTimer->stop(); // Paused
+		return;
+		}
+	if (accelerate)
+		m_FastPolls = FAST_POLL_COUNT;
+	if (accelerate || !m_pPropertyTimer->isActive())
+		m_pPropertyTimer->start(PROPERTY_INTERVAL_MIN);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: timeout of the property timer
+void CMainController::_pollExposureProperties() {
+	if (m_FastPolls > 0) {
+		m_FastPolls--;
+		m_PropertyInterval = PROPERTY_INTERVAL_MIN;
+		}
+	else if (m_PropertiesChanged) {
+		m_PropertyInterval = PROPERTY_INTERVAL;
+		}
+	else {
+		m_PropertyInterval = (2 * m_PropertyInterval < PROPERTY_INTERVAL_MAX) ? 2 * m_PropertyInterval : PROPERTY_INTERVAL_MAX;
+		}
+	m_PropertiesChanged = false;
+	requestExposureProperties();
+	m_pPropertyTimer->start(m_PropertyInterval);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: the next shot of the capture sequence is due at targetTime. From
+// now on no further read-only requests are sent, the trigger thread sends
+// the trigger command on its own connection.
+void CMainController::_captureShotDue(qint64 targetTime) {
+	m_TriggerHeld        = true;
+	m_PendingTriggerTime = targetTime;
+	dispatchScheduledTrigger();
+}
+
+// -----------------------------------------------------------------------
+void CMainController::dispatchScheduledTrigger() {
+	if (m_PendingTriggerTime == 0 || m_StateChangingRequestPending || m_pTriggerScheduler == nullptr)
+		return;
+	const QByteArray path = getCommandRequest(m_CombinedTrigger ? EOC1st2ndPush : EOC2ndPush).url().toEncoded(QUrl::RemoveScheme | QUrl::RemoveAuthority);
+	m_StateChangingRequestPending = true; // Until _triggerFinished()
+	QMetaObject::invokeMethod(m_pTriggerScheduler, "trigger", Qt::QueuedConnection, Q_ARG(qint64, m_PendingTriggerTime), Q_ARG(QByteArray, path));
+	m_PendingTriggerTime = 0;
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: reply of a scheduled trigger, the release follows without
+// waiting for the state machine
+void CMainController::_triggerFinished(qint64, qint64 sendTime, bool ok) {
+	m_StateChangingRequestPending = false;
+	m_TriggerHeld                 = false;
+	if (!ok) {
+		if (m_pCaptureSequencer->isRunning()) {
+			m_OlyCameraCommands.clear();
+			m_StateMachine.error();
+			}
+		else if (!m_OlyCameraCommands.empty()) {
+			processCameraCommand(); // Requests held back while the trigger was due
+			}
+		return;
+		}
+	m_pCaptureSequencer->shotSent(sendTime);
+	m_OlyCameraCommands.push(m_CombinedTrigger ? EOC2nd1stRelease : EOC2ndRelease);
+	processCameraCommand();
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: all shots taken or stopped by the user
+void CMainController::_captureSequenceFinished() {
+	if (m_StateMachine.getStateId() == Sequence)
+		qDebug("%s", m_pCaptureSequencer->getSummary().c_str());
+	m_StateMachine.sequenceStopped();
+}
+
 // -----------------------------------------------------------------------
 // Qt slot: Wifi status has changed
 void CMainController::_notifyWifiStatusChanged() {
 	EWifiStatus status = (EWifiStatus)m_upWifiStatus->getValue();
 	switch (status) {
 		case EWifiConnected :
-		case EWifiOlyCameraConnected : {
-					if (m_pUDPServerSocket == nullptr) {
-						m_pUDPServerSocket = new QUdpSocket(this);
-						QHostAddress addr(QString::fromStdString(m_upLocalIpAddress->getValue()));
-						//QHostAddress addr("192.168.178.22");
-						bool success = m_pUDPServerSocket->bind(addr, 0, QUdpSocket::ShareAddress|QUdpSocket::ReuseAddressHint);
-						quint16 port = m_pUDPServerSocket->localPort();
-						QAbstractSocket::SocketState state = m_pUDPServerSocket->state();
-						connect(m_pUDPServerSocket, &QUdpSocket::readyRead, this, &CMainController::udpReadyRead);
-						}
-					} break;
-		default:	if (m_pUDPServerSocket != nullptr) {
-						disconnect(m_pUDPServerSocket, &QUdpSocket::readyRead, this, &CMainController::udpReadyRead);
-						delete m_pUDPServerSocket;
-						m_pUDPServerSocket = nullptr;
-						}
+		case EWifiOlyCameraConnected :
+					// Blocking: the port is required for the next "startliveview"
+					QMetaObject::invokeMethod(m_pLiveViewReceiver, "start", Qt::BlockingQueuedConnection,
+											  Q_ARG(QString, QString::fromStdString(m_upLocalIpAddress->getValue())));
+					invalidateCommandRequests(); // "startliveview" with the new port
+					break;
+		default:	QMetaObject::invokeMethod(m_pLiveViewReceiver, "stop", Qt::QueuedConnection);
 					break;
 		}
 }
@@ -631,65 +1139,81 @@ void CMainController::_notifyWifiStatusChanged() {
 // -----------------------------------------------------------------------
 // Qt slot
 void CMainController::httpFinished() {
-	if (m_pNetworkReply == nullptr) return;
-
-	QNetworkReply::NetworkError error = m_pNetworkReply->error();
+	OLYCAMERARC_TRACE_SCOPE("httpFinished");
+	QNetworkReply * pReply = qobject_cast<QNetworkReply*>(sender());
+	auto it = m_NetworkReplies.find(pReply);
+	if (it == m_NetworkReplies.end()) return;
+
+	const EOlyCommands cmd = it->second.cmd;
+	OLYCAMERARC_TRACE_ASYNC_END(OLY_COMMAND_NAMES[cmd], pReply);
+	if (!isReadOnlyCommand(cmd))
+		m_StateChangingRequestPending = false;
+	QByteArray buffer;
+	buffer.swap(it->second.data);
+	m_NetworkReplies.erase(it);
+	pReply->deleteLater();
+
+	QNetworkReply::NetworkError error = pReply->error();
 	if (error != QNetworkReply::NoError) {
 		wDebug(QString("NetworkReply error: %1").arg((int)error));
-		m_pNetworkReply->deleteLater();
-		m_pNetworkReply = nullptr;
+		if (cmd == EOCRequestDescList)
+			m_HasDescList = false; // Falls back to the single property requests
 
-		while (!m_OlyCameraCommands.empty()) // Empties the queue
-			m_OlyCameraCommands.pop();
+		if (isReadOnlyCommand(cmd)) {
+			// A failed poll: the queued control commands (e.g. a release) are still sent
+			m_OlyCameraCommands.clearBackground();
+			if (!m_OlyCameraCommands.empty())
+				processCameraCommand();
+			return;
+			}
+		m_OlyCameraCommands.clear();
 
 		m_StateMachine.error();
 		return;
 		}
 
-	QByteArray buffer = m_pNetworkReply->readAll();
-	std::string reply = buffer.toStdString();
-	if (!reply.empty()) wDebug(QString::fromStdString(reply));
-	m_pNetworkReply->deleteLater();
-	m_pNetworkReply = nullptr;
+	buffer.append(pReply->readAll()); // Remainder not yet taken by httpReadyRead()
+	if (W_DEBUG_ENABLED && !buffer.isEmpty()) wDebug(QString::fromUtf8(buffer)); // The reply is parsed in place
 
-	const EOlyCommands & cmd = m_OlyCameraCommands.front();
 	switch (cmd) {
 		case EOCSetRecMode:
 					m_CameraMode = ECM_RecMode;
+					QMetaObject::invokeMethod(m_pLiveViewReceiver, "setLiveViewQuality", Qt::QueuedConnection, Q_ARG(int, (int)m_LiveViewQuality));
+					adaptPropertyPolling(true);
 					break;
 		case EOCSetShutterMode:
 					m_CameraMode = ECM_ShutterMode;
 					break;
+		case EOCStartLiveView:
+		case EOCStopLiveView:
+					m_LiveViewQualityController.restart(CLatencyClock::now()); // No measurement across a start/stop
+					break;
+		case EOCSetPlayMode:
+					m_CameraMode = ECM_PlayMode;
+					m_pImageLibrary->requestImageList();
+					break;
 		case EOCRequestShutterSpeed:
 		case EOCRequestFocalValue:
 		case EOCRequestEVValue:
 		case EOCRequestISOValue:
-                    analyseEmitReply(cmd, reply);
+		case EOCRequestCameraDriveMode:
+		case EOCRequestDescList:
+                    analyseEmitReply(cmd, buffer);
                     break;
-        case EOCRequestCameraDriveMode: {
-                    // Possible values: "normal", "continuous", "selftimer", "customselftimer",
-                    // "livetime" (composite mode)
-                    const std::string s = analyseReply(cmd, reply);
-                    if      (s.find("normal") == 0)  m_ExposureMode = EEM_Normal;
-                    else if (s.find("cont")   == 0)  m_ExposureMode = EEM_Continuous;
-                    else if (s.find("self")   == 0)  m_ExposureMode = EEM_Self;
-                    else if (s.find("livetime") == 0)  m_ExposureMode = EEM_Composite;
-                    else                             m_ExposureMode = EEM_Undefined;
-                    emit notifyCameraValueChanged(QVariant((int)cmd), QVariant((int)m_ExposureMode));
-                    } break;
         case EOCGetRecView :
                     break;
-        case EOCStoreImage :
-                    m_pRTPDatagramHandler->processDatagram(buffer);
+        case EOCStoreImage : // Images are downloaded by CImageLibrary
                     break;
         case EOCRequestCommandList :
-                    analyseCommandList(reply);
+                    analyseCommandList(buffer);
                     break;
 		default:	break;
 		}
 
-	m_StateMachine.commandsProcessed(m_OlyCameraCommands.front());
-	m_OlyCameraCommands.pop();
+	if ((cmd == EOC2ndRelease || cmd == EOC2nd1stRelease) && m_pCaptureSequencer != nullptr)
+		m_pCaptureSequencer->shotCompleted();
+	m_StateMachine.commandsProcessed(cmd);
+	dispatchScheduledTrigger();
 
 	if (!m_OlyCameraCommands.empty()) {
 		processCameraCommand();
@@ -698,20 +1222,28 @@ void CMainController::httpFinished() {
 
 // -----------------------------------------------------------------------
 // Qt slot
+// Takes the received data, the buffer is allocated once according to
+// "Content-Length". Measures the time to the first byte of the reply.
 void CMainController::httpReadyRead() {
-	// This slot gets called every time the QNetworkReply has new data in its buffer.
-	// Here is the possibility to read these data
-}
-
-// -----------------------------------------------------------------------
-// Qt slot
-void CMainController::udpReadyRead() {
-	// This slot gets called every time a datagram is in the buffer of QUdpSocket.
-	// Here is the possibility to read these data
-	while (m_pUDPServerSocket->hasPendingDatagrams()) {
-		QNetworkDatagram datagram = m_pUDPServerSocket->receiveDatagram();
-		m_pRTPDatagramHandler->processDatagram(datagram.data());
-	}
+	QNetworkReply * pReply = qobject_cast<QNetworkReply*>(sender());
+	auto it = m_NetworkReplies.find(pReply);
+	if (it == m_NetworkReplies.end()) return;
+
+	CRequestInFlight & inFlight = it->second;
+	if (inFlight.firstByteTime == 0) {
+		inFlight.firstByteTime = CLatencyClock::now();
+		m_TimeToFirstByte.add(inFlight.firstByteTime - inFlight.sendTime);
+		if (m_TimeToFirstByte.getCount() >= m_NextStatisticsLog) {
+			m_NextStatisticsLog += STATISTICS_LOG_INTERVAL;
+			qDebug("Time to first byte: p50 %.1f ms, p95 %.1f ms, max %.1f ms (%llu)",
+				   m_TimeToFirstByte.getPercentile(50.0) / 1e6, m_TimeToFirstByte.getPercentile(95.0) / 1e6,
+				   m_TimeToFirstByte.getMax() / 1e6, (unsigned long long)m_TimeToFirstByte.getCount());
+			}
+		const qint64 contentLength = pReply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+		if (contentLength > 0)
+			inFlight.data.reserve((int)contentLength);
+		}
+	inFlight.data.append(pReply->readAll());
 }
 
 
@@ -742,6 +1274,7 @@ void CQMLBackend::init(CMainController * pOwner, QWidget * pRootWidget) {
 	connect(pMainWindow->getFocusButton(), SIGNAL(clicked(bool)), this, SLOT(onFocusButtonClicked(bool)));
 	connect(pMainWindow->getShutterButton(), SIGNAL(pressed()), this, SLOT(onShutterButtonPressed()));
 	connect(pMainWindow->getShutterButton(), SIGNAL(released()), this, SLOT(onShutterButtonReleased()));
+	connect(pMainWindow->getSequenceButton(), SIGNAL(clicked(bool)), this, SLOT(onSequenceButtonClicked(bool)));
 }
 
 // -----------------------------------------------------------------------
@@ -779,6 +1312,11 @@ void CQMLBackend::onShutterButtonReleased() {
 	m_pOwner->shutterButtonReleased();
 }
 
+// -----------------------------------------------------------------------
+void CQMLBackend::onSequenceButtonClicked(bool checked) {
+	m_pOwner->sequenceButtonClicked(checked);
+}
+
 
 // -----------------------------------------------------------------------
 // Class CMainStateMachine
@@ -788,6 +1326,8 @@ CMainStateMachine::CMainStateMachine() : m_pCurrentState(nullptr) {}
 // -----------------------------------------------------------------------
 void CMainStateMachine::setCurrentState(CMainStateMachine::IState * pState) {
 	m_pCurrentState = pState;
+	if (pState != nullptr)
+		OLYCAMERARC_TRACE_INSTANT(STATE_NAMES[pState->getId()]);
 }
 
 // -----------------------------------------------------------------------
@@ -817,6 +1357,12 @@ void CMainStateMachine::shutterButtonPressed() { m_pCurrentState->pressShutterBu
 // -----------------------------------------------------------------------
 void CMainStateMachine::shutterButtonReleased() { m_pCurrentState->releaseShutterButton(this); }
 
+// -----------------------------------------------------------------------
+void CMainStateMachine::sequenceStarted() { m_pCurrentState->startSequence(this); }
+
+// -----------------------------------------------------------------------
+void CMainStateMachine::sequenceStopped() { m_pCurrentState->stopSequence(this); }
+
 // -----------------------------------------------------------------------
 void CMainStateMachine::commandsProcessed(EOlyCommands cmd) { m_pCurrentState->commandsProcessed(this, cmd); }
 
@@ -839,125 +1385,13 @@ bool CMainStateMachine::isRecModeAvail() const {
 		   m_pCurrentState == CInitState::getInstance() ||
 		   m_pCurrentState == CFocusReleaseState::getInstance();
 }
-
-
-// -----------------------------------------------------------------------
-// Class CRTPDatagramHandler
 // -----------------------------------------------------------------------
-void CRTPDatagramHandler::processDatagram(const QByteArray & data) {
-	const u_int8_t *   pData = (u_int8_t*)data.data();
-	int                size0 = data.size();
-	bool   headerInitialized = false;
-	u_int16_t sequenceNumber = 0, m_CSRC_Count = 0;
-	u_int8_t         version = 0, payloadType = 0, CSRC_Count = 0;
-	bool             padding = false, extension = false, marker = false;
-
-	// Decodes an RTP packet and extracts marker, sequence number, and (partial) payload
-	// The payload is part of several RTP packets.
-	// Based on: https://en.wikipedia.org/wiki/Real-time_Transport_Protocol
-	if (size0 > 0) {
-		version		= *(pData + 0) >> 6;
-		padding		= (*(pData + 0) & 0x20) >> 5;
-		extension	= (*(pData + 0) & 0x10) >> 4;
-		CSRC_Count  = (*(pData + 0) & 0x0F);
-		}
-	if (size0 > 1) {
-		marker		= (*(pData + 1) & 0x80) >> 7;
-		payloadType = (*(pData + 1) & 0x7F); // @see: https://en.wikipedia.org/wiki/RTP_payload_formats
-		}
-	if (size0 > 3) {
-		sequenceNumber    = (*(pData + 2) << 8) + *(pData + 3);
-		headerInitialized = true;
-		}
-
-	if (headerInitialized) {
-		u_int32_t payloadStart = 12 + 4*CSRC_Count; // Calculated without extension header
-		if (extension) {
-			u_int16_t  extHeaderID = (*(pData + payloadStart + 0) << 8) + *(pData + payloadStart + 1);
-			u_int16_t extHeaderLen = (*(pData + payloadStart + 2) << 8) + *(pData + payloadStart + 3);
-			payloadStart += (4 * extHeaderLen + 4 /* fields of header ID and length */);
-			}
-
-		u_int16_t amountPadding = (padding) ? data.at(data.size()-1) : 0;
-		u_int16_t   payloadSize = data.size() - payloadStart - amountPadding;
-		m_PartialPayload.append((const char*)(pData + payloadStart), payloadSize);
-		}
-
-	if (headerInitialized && marker) {
-		if (m_PayloadNumber > 0 && m_Payloads.size() < 20) { // The first partialPayload may be a fractional payload. Limits the queue.
-			m_Payloads.push(m_PartialPayload);
-			mvc::Model::setChanged();
-			mvc::Model::notifyAll();
-			}
-		m_PartialPayload.clear();
-		m_PayloadNumber++;
-		}
+EState CMainStateMachine::getStateId() const {
+	return (m_pCurrentState != nullptr) ? m_pCurrentState->getId() : Init;
 }
 
 
 namespace {
-// -----------------------------------------------------------------------
-// Anonymous class CNetworkObserver
-// -----------------------------------------------------------------------
-void CNetworkObserver::run() {
-	const unsigned short  TIMEOUT_INTERVAL =   50; // ms
-	const unsigned short     WIFI_INTERVAL = 2000; // ms
-	const unsigned short PROPERTY_INTERVAL =  500; // ms
-	setAutoDelete(true);
-	unsigned short wifiCounter = 0;
-	while(!m_StopRequest) {
-		QThread::msleep(TIMEOUT_INTERVAL);
-
-		if ((wifiCounter % (WIFI_INTERVAL/TIMEOUT_INTERVAL)) == 0) {
-			QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
-			bool                   anyWifiFound = false;
-			bool                   olyWifiFound = false;
-			for (auto &interface : interfaces) {
-				if (interface.isValid() && (interface.flags() & QNetworkInterface::IsUp) > 0 &&
-#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
-				((interface.type() == QNetworkInterface::Wifi) ||
-				 (interface.type() == QNetworkInterface::Unknown && interface.name().indexOf("wlan") >= 0))
-#else
-				 (interface.name().indexOf("wlan") >= 0)
-#endif
-					) {
-					anyWifiFound       = true;
-                    std::string gateway= de::bswalz::network::CNetworkHelper::getDefaultGateway(); // Does not work with 2 different network cards [2024-09-09]
-					if (gateway == OLY_DEFAULT_GATEWAY) {
-						const auto addresses  = interface.addressEntries();
-						for (auto &localIpAddress : addresses) {
-							QHostAddress    hostaddr = localIpAddress.ip();
-							const std::string ipaddr = hostaddr.toString().toStdString();
-							if (ipaddr.find('.') != std::string::npos) // Checks for IPv4 address
-								m_pOwner->getLocalIpAddress()->assignValue(ipaddr);
-							}
-						olyWifiFound = true;
-						break;
-						}
-					} // End if interface ist up and valid
-				} // End for all interfaces
-			if (anyWifiFound && !olyWifiFound) {
-				m_pOwner->getLocalIpAddress()->assignValue(LOCAL_HOST);
-				m_pOwner->getWifiStatus()->assignValue(EWifiConnected);
-				}
-			else if (olyWifiFound) {
-				m_pOwner->getWifiStatus()->assignValue(EWifiOlyCameraConnected);
-				}
-			else {
-				m_pOwner->getLocalIpAddress()->assignValue(LOCAL_HOST);
-				m_pOwner->getWifiStatus()->assignValue(EWifiNotConnected);
-				}
-			} // End if (WIFI_INTERVAL/TIMEOUT_INTERVAL)) == 0
-
-		if ((wifiCounter % (PROPERTY_INTERVAL/TIMEOUT_INTERVAL)) == 0 &&
-			m_pOwner->getWifiStatus()->getValue() == EWifiOlyCameraConnected) {
-			m_pOwner->requestExposureProperties();
-			} // End if (PROPERTY_INTERVAL/TIMEOUT_INTERVAL)) == 0
-
-		wifiCounter++;
-	} // End while
-}
-
 // -----------------------------------------------------------------------
 // Anonymous class CInitState
 // -----------------------------------------------------------------------
@@ -974,6 +1408,10 @@ void CInitState::pressFocusButton(CMainStateMachine * pStateMachine) {
 	pStateMachine->notifyListeners();
 }
 // -----------------------------------------------------------------------
+void CInitState::startSequence(CMainStateMachine * pStateMachine) {
+	CSequenceState::getInstance()->enter(pStateMachine, this);
+}
+// -----------------------------------------------------------------------
 void CInitState::commandsProcessed(CMainStateMachine *, EOlyCommands) {
 	// ToDo:
 }
@@ -1031,6 +1469,10 @@ void CFocussedState::pressShutterButton(CMainStateMachine * pStateMachine) {
 	pStateMachine->notifyListeners();
 }
 // -----------------------------------------------------------------------
+void CFocussedState::startSequence(CMainStateMachine * pStateMachine) {
+	CSequenceState::getInstance()->enter(pStateMachine, this);
+}
+// -----------------------------------------------------------------------
 void CFocussedState::tearDown(CMainStateMachine *) {
 	// ToDo:
 }
@@ -1139,6 +1581,32 @@ void CTriggerReleaseState::tearDown(CMainStateMachine *) {
 	// ToDo:
 }
 
+// -----------------------------------------------------------------------
+// Anonymous class CSequenceState
+// -----------------------------------------------------------------------
+std::unique_ptr<CSequenceState> CSequenceState::m_upInstance = std::unique_ptr<CSequenceState>();
+// -----------------------------------------------------------------------
+CSequenceState * CSequenceState::getInstance() {
+	if (m_upInstance.get() == nullptr)
+		m_upInstance.reset(new CSequenceState());
+	return m_upInstance.get();
+}
+// -----------------------------------------------------------------------
+void CSequenceState::enter(CMainStateMachine * pStateMachine, CMainStateMachine::IState * pReturnState) {
+	m_pReturnState = pReturnState;
+	pStateMachine->setCurrentState(this);
+	pStateMachine->notifyListeners();
+}
+// -----------------------------------------------------------------------
+void CSequenceState::stopSequence(CMainStateMachine * pStateMachine) {
+	pStateMachine->setCurrentState(m_pReturnState != nullptr ? m_pReturnState : CInitState::getInstance());
+	pStateMachine->notifyListeners();
+}
+// -----------------------------------------------------------------------
+void CSequenceState::tearDown(CMainStateMachine *) {
+	// Intentionally left blank
+}
+
 } // End of anonymous namespace
 
 }}} // End namespaces
@@ -32,20 +32,29 @@
 
 #include "types.h"
 #include "maincontroller.h"
+#include "cameraproperties.h"
+#include "commandlist.h"
+#include "latencystatistics.h"
+#include "liveviewqualitycontroller.h"
+#include "liveviewrecorder.h"
 #include <QObject>
 #include <QVariant>
+#include <QByteArray>
+#include <QtNetwork/QNetworkRequest>
+#include <deque>
+#include <map>
 #include <memory>
-#include <queue>
 #include <set>
+#include <vector>
 #include <common/mvc/View.h>		// Separate git-repo
 #include <common/model/Parameter.h>	// Separate git-repo
 
-class QRunnable;
 class QCoreApplication;
 class QNetworkAccessManager;
 class QNetworkReply;
-class QUdpSocket;
-class QNetworkDatagram;
+class QThread;
+class QTimer;
+class QString;
 
 namespace de { namespace bswalz {
 namespace mvc {
@@ -62,7 +71,11 @@ using de::bswalz::mvc::Model;
 using namespace de::bswalz::model;
 
 class CMainController;
-class CRTPDatagramHandler;
+class CLiveViewReceiver;
+class CNetworkMonitor;
+class CCaptureSequencer;
+class CTriggerScheduler;
+class CImageLibrary;
 
 // -----------------------------------------------------------------------
 // Class CQMLBackend
@@ -89,6 +102,7 @@ protected slots:
 	void onShutterButtonPressed();
 	void onShutterButtonReleased();
 	void onFocusButtonClicked(bool);
+	void onSequenceButtonClicked(bool);
 
 private:
 	QWidget *			m_pRootWidget;
@@ -108,6 +122,8 @@ public:
 		virtual void releaseFocusButton(CMainStateMachine *) {}
 		virtual void pressShutterButton(CMainStateMachine *) {}
 		virtual void releaseShutterButton(CMainStateMachine *) {}
+		virtual void startSequence(CMainStateMachine *) {}
+		virtual void stopSequence(CMainStateMachine *) {}
 		virtual void commandsProcessed(CMainStateMachine *, EOlyCommands) {}
 		virtual void timeout(CMainStateMachine *) {}
 		virtual void error(CMainStateMachine *) {}
@@ -125,6 +141,8 @@ public:
 	void focusButtonReleased();
 	void shutterButtonPressed();
 	void shutterButtonReleased();
+	void sequenceStarted();
+	void sequenceStopped();
 	void commandsProcessed(EOlyCommands);
 	void error();
 	void timeout();
@@ -133,6 +151,7 @@ public:
 	void removeListener(IStateListener *);
 	void setCurrentState(CMainStateMachine::IState *);
 	bool isRecModeAvail() const;
+	EState getStateId() const;
 	virtual ~CMainStateMachine() {}
 protected:
 	void init();
@@ -143,6 +162,43 @@ private:
 	std::set<IStateListener*>		m_StateListeners;
 };
 
+// -----------------------------------------------------------------------
+// Class CCommandQueue
+// Camera commands in two lanes: state changing commands (control lane)
+// always precede the read-only polling (background lane). Background
+// commands are coalesced, the periodic polls are dropped when they have
+// waited too long.
+// -----------------------------------------------------------------------
+class CCommandQueue {
+public:
+	static const int64_t MAX_BACKGROUND_AGE = 1000000000LL;	// ns, two polling periods
+
+	CCommandQueue() : m_CoalescedCommands(0uL), m_DroppedCommands(0uL) {}
+	void			push(EOlyCommands);
+	bool			empty();
+	/** Next command, the control lane first */
+	EOlyCommands	front();
+	void			pop();
+	void			clear();
+	/** Drops the polling only */
+	void			clearBackground();
+	u_int32_t		getCoalescedCommands() const { return m_CoalescedCommands; }
+	u_int32_t		getDroppedCommands() const { return m_DroppedCommands; }
+private:
+	class CEntry {
+	public:
+		CEntry(EOlyCommands c, int64_t t) : cmd(c), enqueueTime(t) {}
+		EOlyCommands	cmd;
+		int64_t			enqueueTime;	// CLatencyClock
+	};
+	void			dropStaleCommands();
+
+	std::deque<EOlyCommands>	m_ControlLane;
+	std::deque<CEntry>			m_BackgroundLane;
+	u_int32_t					m_CoalescedCommands;
+	u_int32_t					m_DroppedCommands;
+};
+
 // -----------------------------------------------------------------------
 // Class CMainController (Singleton)
 // -----------------------------------------------------------------------
@@ -168,6 +224,8 @@ public:
 	void	shutterButtonReleased();
 	/** Callback from QML backend */
 	void	focusButtonClicked(bool);
+	/** Callback from QML backend: starts / stops a capture sequence */
+	void	sequenceButtonClicked(bool);
 
 	/** Access to Wifi status */
     virtual CEnumParameter * getWifiStatus() const override { return m_upWifiStatus.get(); }
@@ -179,6 +237,18 @@ public:
     virtual bool hasShutterSpeedValue() const override { return m_HasShutterSpeedValue; }
     /** Access to property "life view enabled" */
     virtual void setLifeViewEnabled(bool enabled) override;
+    /** Access to latest LifeView image */
+    virtual bool takeLifeViewImage(CLiveViewFrame &) override;
+    /** Measurement of the adaptive LiveView quality */
+    virtual void lifeViewImageDecoded(const CLiveViewFrame &) override;
+    /** Pins resp. adapts "lvqty" */
+    virtual void setLiveViewQuality(int quality) override;
+    /** Starts resp. stops recording LifeView */
+    virtual bool setLiveViewRecordingEnabled(bool enabled, QString & error) override;
+    /** Switches to play mode, only in state Init */
+    virtual void setPlayModeEnabled(bool enabled) override;
+    /** Access to the images on the camera */
+    virtual CImageLibrary * getImageLibrary() const override { return m_pImageLibrary; }
 
     /** Requests command list of camera */
     void    requestCommandList();
@@ -188,23 +258,45 @@ public:
 	void	requestLifeViewImage();
     /** Potentially starts / stops LifeView */
     void    enqueueLifeViewCommand(bool start);
+	/** Requests without side effects, they may run in parallel */
+	static bool isReadOnlyCommand(EOlyCommands);
+	/** True if commands are queued or in flight */
+	bool	hasPendingCommands();
 protected:
 	CMainController();
 	void	updateWifiStatus();
 	void	processCameraCommand();
-    void    analyseCommandList(const std::string &);
-    void    analyseEmitReply(EOlyCommands, const std::string &);
-    std::string analyseReply(EOlyCommands, const std::string &);
+	QString	getCommandUrl(EOlyCommands) const;
+	/** Prepared request of a command, its URL is empty if the command can't be sent (yet) */
+	const QNetworkRequest & getCommandRequest(EOlyCommands);
+	/** Has to be called when an URL parameter changes (camera address, "lvqty", LiveView port) */
+	void	invalidateCommandRequests();
+	bool	isCommandInFlight(EOlyCommands) const;
+	/** Restarts LiveView with the quality of m_LiveViewQualityController */
+	void	adaptLiveViewQuality();
+	/** Feeds the packet counters to m_LiveViewQualityController and evaluates its window */
+	void	evaluateLiveViewQuality();
+	/** Hands a due shot to the trigger thread as soon as no state changing request is in flight */
+	void	dispatchScheduledTrigger();
+	/** Starts, pauses or accelerates the polling of the exposure properties */
+	void	adaptPropertyPolling(bool accelerate);
+    void    analyseCommandList(const QByteArray &);
+    void    analyseEmitReply(EOlyCommands, const QByteArray &);
+    void    notifyExposureProperty(EOlyCommands, const std::string &);
 
 protected slots:
 	void	tearDown();
 	void	httpFinished();
 	void	httpReadyRead();
-	void	udpReadyRead();
 	void	_requestExposureProperties();
 	void    _requestLifeViewImage();
     void    _requestCommandList();
 	void    _notifyWifiStatusChanged();
+	void    _networkChanged(int, QString);
+	void    _pollExposureProperties();
+	void    _captureShotDue(qint64);
+	void    _captureSequenceFinished();
+	void    _triggerFinished(qint64, qint64, bool);
 
 signals:
 	void    dispatchExposurePropertiesRequest();
@@ -214,20 +306,61 @@ signals:
 	void	notifyCameraValueChanged(QVariant,QVariant);
 
 private:
+	class CRequestInFlight {
+	public:
+		CRequestInFlight() : cmd(EOCNoCommand), sendTime(0), firstByteTime(0) {}
+		EOlyCommands	cmd;
+		int64_t			sendTime;		// CLatencyClock
+		int64_t			firstByteTime;	// CLatencyClock, 0: nothing received yet
+		QByteArray		data;			// Received by httpReadyRead()
+	};
+
 	static	std::unique_ptr<CMainController> m_upInstance;
-	QRunnable *			m_pNetworkObserver;
-	QUdpSocket *		m_pUDPServerSocket;
+	static const quint64 STATISTICS_LOG_INTERVAL = 100;	// Replies
+	static const unsigned int MAX_PARALLEL_REQUESTS = 5;	// Read-only requests in flight
+	static const int PROPERTY_INTERVAL     =  500;	// ms, after a change
+	static const int PROPERTY_INTERVAL_MIN =  250;	// ms, after user interaction or mode switch
+	static const int PROPERTY_INTERVAL_MAX = 8000;	// ms, values stable for a longer time
+	static const int FAST_POLL_COUNT       =    4;
+	CNetworkMonitor *	m_pNetworkMonitor;
+	QTimer *			m_pPropertyTimer;
+	CCaptureSequencer *	m_pCaptureSequencer;
+	bool				m_CombinedTrigger;		// 1st2ndpush / 2nd1strelease per shot instead of 2ndpush / 2ndrelease
+	CImageLibrary *		m_pImageLibrary;
+	bool				m_PlayModeEnabled;		// No polling, no LiveView
+	CTriggerScheduler *	m_pTriggerScheduler;
+	QThread *			m_pTriggerThread;
+	bool				m_TriggerHeld;			// Shot due: no read-only requests until its trigger is replied
+	qint64				m_PendingTriggerTime;	// CLatencyClock of the shot waiting for dispatchScheduledTrigger(), 0: none
+	int					m_PropertyInterval;		// ms
+	int					m_FastPolls;
+	bool				m_PropertiesChanged;	// Since the last poll
+	std::map<EOlyCommands, std::string> m_ExposurePropertyValues;	// Last values notified
+	QThread *			m_pLiveViewThread;
 	QNetworkAccessManager * m_pNetworkAccessManager;
-	QNetworkReply *		m_pNetworkReply;
-	CRTPDatagramHandler* m_pRTPDatagramHandler;
+	std::map<QNetworkReply*, CRequestInFlight> m_NetworkReplies;	// Requests in flight
+	std::vector<QNetworkRequest> m_CommandRequests;	// Index: EOlyCommands
+	CLatencyHistogram	m_TimeToFirstByte;	// Request sent -> first byte of the reply
+	quint64				m_NextStatisticsLog;
+	bool				m_StateChangingRequestPending;
+	CLiveViewReceiver *	m_pLiveViewReceiver;
 	CQMLBackend			m_QMLBackend;
 	CMainStateMachine	m_StateMachine;
 	ECameraMode			m_CameraMode;
     EExposeMode         m_ExposureMode;
     bool                m_HasShutterSpeedValue;
+    bool                m_HasDescList;
     bool                m_LifeViewEnabled;
     bool                m_LifeViewPotentiallyStarted;
-	std::queue<EOlyCommands> m_OlyCameraCommands;
+    ELiveViewQuality    m_LiveViewQuality;	// "lvqty" of EOCSetRecMode
+	CLiveViewQualityController m_LiveViewQualityController;
+	CLiveViewRecorder	m_LiveViewRecorder;
+    std::string         m_CameraAddress;	// host[:port] of the HTTP server
+	CCommandQueue		m_OlyCameraCommands;
+	int64_t				m_ButtonPressTime;	// CLatencyClock, 0: no button pressed
+	CLatencyHistogram	m_TriggerLatency;	// Button press -> sending of 1stpush / 2ndpush
+	CCameraPropertyTable m_CameraProperties;
+	CCommandList		m_CommandList;
 
 	std::unique_ptr<CEnumParameter> m_upWifiStatus;
 	std::unique_ptr<CAStringParameter> m_upLocalIpAddress;
@@ -31,6 +31,9 @@
  */
 
 #include "types.h"
+#include <QByteArray>
+#include <QMetaType>
+#include <QString>
 #include <common/mvc/View.h>		// Separate git-repo
 #include <common/model/Parameter.h>	// Separate git-repo
 
@@ -44,10 +47,26 @@ class CEnumParameter;
 
 namespace olycamerarc {
 
+class CImageLibrary;
+
 using de::bswalz::mvc::View;
 using de::bswalz::mvc::Model;
 using namespace de::bswalz::model;
 
+// -----------------------------------------------------------------------
+// Class CLiveViewFrame
+// A LiveView image with its timestamps (ns, CLatencyClock, 0: unknown)
+// -----------------------------------------------------------------------
+class CLiveViewFrame {
+public:
+	CLiveViewFrame() : number(0), firstPacketTime(0), completeTime(0), decodedTime(0) {}
+	QByteArray	data;				// JPEG
+	quint32		number;
+	qint64		firstPacketTime;	// First RTP packet received
+	qint64		completeTime;		// Marker packet received
+	qint64		decodedTime;		// Decoding finished
+};
+
 // -----------------------------------------------------------------------
 // Class IMainController (Interface of a Singleton)
 // -----------------------------------------------------------------------
@@ -66,9 +85,24 @@ public:
     virtual bool hasShutterSpeedValue() const = 0;
     /** Access to property "life view enabled" */
     virtual void setLifeViewEnabled(bool) = 0;
+    /** Takes the latest LifeView image, returns false if there is none */
+    virtual bool takeLifeViewImage(CLiveViewFrame &) = 0;
+    /** A LifeView image was decoded and is displayed, measurement of the adaptive quality */
+    virtual void lifeViewImageDecoded(const CLiveViewFrame &) = 0;
+    /** Pins "lvqty" (ELiveViewQuality), -1: adapted to the measured throughput */
+    virtual void setLiveViewQuality(int) = 0;
+    /** Records the LifeView images to an MJPEG AVI file in the movies directory,
+     *  false and the reason in error if the recording can't be started */
+    virtual bool setLiveViewRecordingEnabled(bool enabled, QString & error) = 0;
+    /** Switches the camera to play mode (image list, downloads) resp. back to rec mode */
+    virtual void setPlayModeEnabled(bool) = 0;
+    /** Access to the images on the camera, available in play mode */
+    virtual CImageLibrary * getImageLibrary() const = 0;
 };
 
 
 }}} // End namespaces
 
+Q_DECLARE_METATYPE(de::bswalz::olycamerarc::CLiveViewFrame)
+
 #endif // DE_BSWALZ_OLYCAMERARC_MAIN_H
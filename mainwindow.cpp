@@ -31,12 +31,21 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 #include "maincontroller.h"
+#include "liveviewdecoder.h"
+#include "gallerydialog.h"
+#include "tracing.h"
 #include "types.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QPushButton>
+#include <QComboBox>
+#include <QMessageBox>
 #include <QDateTime>
+#include <QPainter>
+#include <QEvent>
+#include <QDir>
+#include <QStandardPaths>
 
 const QSize WIFI_ICON_SIZE = QSize(20,20);
 const QSize WIFI_LED_SIZE  = QSize(20,20);
@@ -54,15 +63,40 @@ static const QString DFLT_EXP_MODE_TEXT     = "M ---";
 // Class MainWindow
 // -----------------------------------------------------------------------
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), m_pMainController(nullptr) {
+    : QMainWindow(parent), ui(new Ui::MainWindow), m_pMainController(nullptr), m_pLiveViewDecoder(nullptr),
+      m_PaintPending(false), m_LatencyOverlayEnabled(qEnvironmentVariableIsSet("OLYCAMERARC_LATENCY_OVERLAY")) {
 	ui->setupUi(this);
 }
 
 // -----------------------------------------------------------------------
 MainWindow::~MainWindow() {
+	dumpLatencyStatistics();
 	delete ui;
 }
 
+// -----------------------------------------------------------------------
+void MainWindow::dumpLatencyStatistics() {
+	if (m_LatencyStatistics.getHistogram(de::bswalz::olycamerarc::CLatencyStatistics::ELS_Total).getCount() == 0)
+		return;
+	const QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+	QDir().mkpath(path);
+	const QString fileName = path + "/liveview-latency.txt";
+	if (m_LatencyStatistics.dump(fileName.toStdString()))
+		qDebug("LifeView latency statistics written to %s", qPrintable(fileName));
+}
+
+// -----------------------------------------------------------------------
+// Timestamp of painting the LifeView image
+bool MainWindow::eventFilter(QObject * pObject, QEvent * pEvent) {
+	if (pObject == m_pLifeView && pEvent->type() == QEvent::Paint && m_PaintPending) {
+		m_PaintPending = false;
+		OLYCAMERARC_TRACE_INSTANT("LifeView paint");
+		m_LatencyStatistics.addFrame(m_PaintPendingFrame.firstPacketTime, m_PaintPendingFrame.completeTime,
+									 m_PaintPendingFrame.decodedTime, de::bswalz::olycamerarc::CLatencyClock::now());
+		}
+	return QMainWindow::eventFilter(pObject, pEvent);
+}
+
 // -----------------------------------------------------------------------
 void MainWindow::layoutUI() {
 	const QRect & geom = this->geometry();
@@ -94,6 +128,22 @@ void MainWindow::layoutUI() {
 	m_pWifiLED->setMaximumSize(35,35);
 	m_pOlyWifiLED->setPixmap(QPixmap(":/res/led-gr.png").scaled(WIFI_LED_SIZE));
 	m_pOlyWifiLED->setMaximumSize(35,35);
+	m_pGalleryButton = new QPushButton("Gallery");
+	m_pGalleryButton->setToolTip("Images on the camera");
+	m_pGalleryButton->setEnabled(false);
+	pHeadlineLayout->addWidget(m_pGalleryButton);
+	m_pLiveViewQualityBox = new QComboBox();
+	m_pLiveViewQualityBox->setToolTip("LifeView resolution, \"Auto\": adapted to the link");
+	m_pLiveViewQualityBox->addItems(QStringList() << "Auto" << "320x240" << "640x480" << "800x600" << "1024x768" << "1280x960");
+	pHeadlineLayout->addWidget(m_pLiveViewQualityBox);
+	m_pPeakingButton = new QPushButton("Peaking");
+	m_pPeakingButton->setToolTip("Focus peaking: highlights sharp edges in LifeView");
+	m_pPeakingButton->setCheckable(true);
+	pHeadlineLayout->addWidget(m_pPeakingButton);
+	m_pHistogramButton = new QPushButton("Histogram");
+	m_pHistogramButton->setToolTip("Luminance and RGB histogram of LifeView");
+	m_pHistogramButton->setCheckable(true);
+	pHeadlineLayout->addWidget(m_pHistogramButton);
 	pHeadlineLayout->addWidget(m_pWifiLED);
 	pHeadlineLayout->addWidget(m_pOlyWifiLED);
 
@@ -104,6 +154,8 @@ void MainWindow::layoutUI() {
 	m_pLifeView->setMinimumHeight(240);
 	m_pLifeView->setAlignment(Qt::AlignHCenter);
 	m_pLifeView->setPixmap(QPixmap(":/res/lifeview-disabled.png").scaled(m_pLifeView->size(), Qt::KeepAspectRatio));
+	m_pLifeView->installEventFilter(this);
+	m_pLiveViewDecoder = new de::bswalz::olycamerarc::CLiveViewDecoder(this);
 
     m_pLifeViewButton = new QPushButton();
     m_pLifeViewButton->setIcon(QIcon(":/res/play_button_released.png"));
@@ -129,6 +181,20 @@ void MainWindow::layoutUI() {
 	m_pShutterButton->setFixedSize(100,100);
 	m_pShutterButton->setIconSize(QSize(100,100));
 
+	m_pSequenceButton = new QPushButton("Seq");
+	m_pSequenceButton->setToolTip("Capture sequence, see OLYCAMERARC_SEQUENCE");
+	m_pSequenceButton->setCheckable(true);
+	m_pSequenceButton->setAutoRepeat(false);
+	m_pSequenceButton->setEnabled(false);
+	m_pSequenceButton->setFixedSize(60,60);
+
+	m_pRecordButton = new QPushButton("Rec");
+	m_pRecordButton->setToolTip("Records LifeView to the movies directory");
+	m_pRecordButton->setCheckable(true);
+	m_pRecordButton->setAutoRepeat(false);
+	m_pRecordButton->setEnabled(false);
+	m_pRecordButton->setFixedSize(60,60);
+
 	ui->main_column_layout->addWidget(m_pLifeView);
 	ui->main_column_layout->addStretch(2);
 
@@ -156,6 +222,10 @@ void MainWindow::layoutUI() {
     pButtonLayout->addWidget(m_pFocusButton);
 	pButtonLayout->addSpacing(50);
 	pButtonLayout->addWidget(m_pShutterButton);
+	pButtonLayout->addSpacing(50);
+	pButtonLayout->addWidget(m_pSequenceButton);
+	pButtonLayout->addSpacing(10);
+	pButtonLayout->addWidget(m_pRecordButton);
 
 	ui->main_column_layout->addItem(pButtonLayout);
 	ui->main_column_layout->addStretch(10);
@@ -163,6 +233,12 @@ void MainWindow::layoutUI() {
 	ui->centralwidget->setLayout(ui->main_column_layout);
 
     connect(this->m_pLifeViewButton, SIGNAL(toggled(bool)), this, SLOT(notifyLifeViewButtonChecked(bool)));
+	connect(m_pRecordButton, SIGNAL(toggled(bool)), this, SLOT(notifyRecordButtonChecked(bool)));
+	connect(m_pGalleryButton, SIGNAL(clicked()), this, SLOT(openGallery()));
+	connect(m_pLiveViewQualityBox, SIGNAL(currentIndexChanged(int)), this, SLOT(liveViewQualityChanged(int)));
+	connect(m_pPeakingButton, SIGNAL(toggled(bool)), this, SLOT(notifyPeakingButtonChecked(bool)));
+	connect(m_pHistogramButton, SIGNAL(toggled(bool)), this, SLOT(notifyHistogramButtonChecked(bool)));
+	connect(m_pLiveViewDecoder, &de::bswalz::olycamerarc::CLiveViewDecoder::imageDecoded, this, &MainWindow::notifyLifeViewImageDecoded);
 }
 
 // -----------------------------------------------------------------------
@@ -174,6 +250,8 @@ void MainWindow::notifyWifiStatusChanged(QVariant arg) {
                 m_pLifeViewButton->setEnabled(false /*false*/);
                 m_pFocusButton->setEnabled(false /*false*/);
 				m_pShutterButton->setEnabled(false /*false*/);
+				m_pSequenceButton->setEnabled(false);
+				m_pGalleryButton->setEnabled(false);
 				m_pWifiLED->setPixmap(QPixmap(":/res/wifi-enabled.png").scaled(WIFI_ICON_SIZE));
 				m_pOlyWifiLED->setPixmap(QPixmap(":/res/led-rt.png").scaled(WIFI_LED_SIZE));
 				m_pLifeView->setPixmap(QPixmap(":/res/lifeview-disabled.png").scaled(m_pLifeView->size(), Qt::KeepAspectRatio));
@@ -182,6 +260,8 @@ void MainWindow::notifyWifiStatusChanged(QVariant arg) {
                 m_pLifeViewButton->setEnabled(true);
                 m_pFocusButton->setEnabled(true);
 				//m_pShutterButton->setEnabled(true); // Depends on state
+				m_pSequenceButton->setEnabled(true);
+				m_pGalleryButton->setEnabled(true);
 				m_pWifiLED->setPixmap(QPixmap(":/res/wifi-enabled.png").scaled(WIFI_ICON_SIZE));
 				m_pOlyWifiLED->setPixmap(QPixmap(":/res/led-gn.png").scaled(WIFI_LED_SIZE));
 				break;
@@ -189,6 +269,8 @@ void MainWindow::notifyWifiStatusChanged(QVariant arg) {
                 m_pLifeViewButton->setEnabled(false);
                 m_pFocusButton->setEnabled(false);
 				m_pShutterButton->setEnabled(false);
+				m_pSequenceButton->setEnabled(false);
+				m_pGalleryButton->setEnabled(false);
 				m_pWifiLED->setPixmap(QPixmap(":/res/wifi-disabled.png").scaled(WIFI_ICON_SIZE));
 				m_pOlyWifiLED->setPixmap(QPixmap(":/res/led-gr.png").scaled(WIFI_LED_SIZE));
 				m_pLifeView->setPixmap(QPixmap(":/res/lifeview-disabled.png").scaled(m_pLifeView->size(), Qt::KeepAspectRatio));
@@ -198,6 +280,12 @@ void MainWindow::notifyWifiStatusChanged(QVariant arg) {
 
 // -----------------------------------------------------------------------
 void MainWindow::notifyCameraStatusChanged(QVariant status) {
+	// Capture sequences start in state Init (camera connected) or Focussed
+	m_pSequenceButton->setChecked(status.toUInt() == de::bswalz::olycamerarc::Sequence);
+	m_pSequenceButton->setEnabled(status.toUInt() == de::bswalz::olycamerarc::Sequence || status.toUInt() == de::bswalz::olycamerarc::Focussed ||
+								  (status.toUInt() == de::bswalz::olycamerarc::Init && m_pLifeViewButton->isEnabled()));
+	// Play mode only without focus
+	m_pGalleryButton->setEnabled(status.toUInt() == de::bswalz::olycamerarc::Init && m_pLifeViewButton->isEnabled());
 	switch (status.toUInt()) {
 		case de::bswalz::olycamerarc::FocusRequest :
 				 m_pFocusButton->setEnabled(false);
@@ -230,6 +318,11 @@ void MainWindow::notifyCameraStatusChanged(QVariant status) {
 				 m_pFocusButton->setIcon(QIcon(":/res/focus_button_pressed.png"));
 				 m_pShutterButton->setEnabled(true);
 				 break;
+		case de::bswalz::olycamerarc::Sequence :
+				 m_pFocusButton->setEnabled(false);
+				 m_pShutterButton->setEnabled(false);
+				 m_pLifeViewButton->setChecked(false);
+				 break;
 		default: m_pFocusButton->setEnabled(true);
 				 m_pFocusButton->setIcon(QIcon(":/res/focus_button_released.png"));
 				 m_pShutterButton->setEnabled(false);
@@ -238,13 +331,30 @@ void MainWindow::notifyCameraStatusChanged(QVariant status) {
 }
 
 // -----------------------------------------------------------------------
-void MainWindow::notifyLifeViewImageChanged(QVariant variant) {
-	qDebug("LifeView image changed");
-	QByteArray data = variant.toByteArray();
-	QImage    image = QImage::fromData(data);
-	QPixmap  pixmap;
-	pixmap.convertFromImage(image);
-	m_pLifeView->setPixmap(pixmap);
+// A new image is available. Decoding is done by worker threads, see notifyLifeViewImageDecoded()
+void MainWindow::notifyLifeViewImageChanged(QVariant) {
+	OLYCAMERARC_TRACE_SCOPE("notifyLifeViewImageChanged");
+	de::bswalz::olycamerarc::CLiveViewFrame frame;
+	if (!m_pMainController->takeLifeViewImage(frame))
+		return;
+	m_pLiveViewDecoder->setTargetSize(m_pLifeView->contentsRect().size());
+	m_pLiveViewDecoder->decode(frame);
+}
+
+// -----------------------------------------------------------------------
+void MainWindow::notifyLifeViewImageDecoded(QImage image, de::bswalz::olycamerarc::CLiveViewFrame frame) {
+	OLYCAMERARC_TRACE_SCOPE("notifyLifeViewImageDecoded");
+	if (m_LatencyOverlayEnabled) { // Debug overlay, enabled by environment variable OLYCAMERARC_LATENCY_OVERLAY
+		QPainter painter(&image);
+		painter.setPen(Qt::yellow);
+		painter.setFont(QFont("Monospace", 7));
+		painter.drawText(image.rect().adjusted(4, 4, -4, -4), Qt::AlignLeft | Qt::AlignTop,
+						 QString::fromStdString(m_LatencyStatistics.toString()));
+		}
+	m_pLifeView->setPixmap(QPixmap::fromImage(image));
+	m_pMainController->lifeViewImageDecoded(frame);
+	m_PaintPendingFrame = frame;	// See eventFilter()
+	m_PaintPending      = true;
 }
 
 // -----------------------------------------------------------------------
@@ -279,5 +389,43 @@ void MainWindow::notifyCameraValueChanged(QVariant key, QVariant value) {
 void MainWindow::notifyLifeViewButtonChecked(bool checked) {
     if (checked) m_pLifeViewButton->setIcon(QIcon(":/res/play_button_pressed.png"));
     else         m_pLifeViewButton->setIcon(QIcon(":/res/play_button_released.png"));
+    if (!checked) dumpLatencyStatistics();
     m_pMainController->setLifeViewEnabled(checked);
+	m_pRecordButton->setEnabled(checked);
+	if (!checked) m_pRecordButton->setChecked(false);
+}
+
+// -----------------------------------------------------------------------
+void MainWindow::notifyRecordButtonChecked(bool checked) {
+	QString error;
+	if (!m_pMainController->setLiveViewRecordingEnabled(checked, error)) {
+		m_pRecordButton->setChecked(false);
+		QMessageBox::warning(this, "LifeView recording", QString("The recording can't be started.\n%1").arg(error));
+		}
+}
+
+// -----------------------------------------------------------------------
+// Qt slot, the overlays are drawn by the decoding workers
+void MainWindow::notifyPeakingButtonChecked(bool checked) {
+	m_pLiveViewDecoder->setFocusPeakingEnabled(checked);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void MainWindow::notifyHistogramButtonChecked(bool checked) {
+	m_pLiveViewDecoder->setHistogramEnabled(checked);
+}
+
+// -----------------------------------------------------------------------
+// The camera is in play mode while the gallery is open
+void MainWindow::openGallery() {
+	de::bswalz::olycamerarc::CGalleryDialog gallery(m_pMainController, this);
+	gallery.resize(size());
+	gallery.exec();
+}
+
+// -----------------------------------------------------------------------
+// Index 0: "Auto", then ELiveViewQuality
+void MainWindow::liveViewQualityChanged(int index) {
+	m_pMainController->setLiveViewQuality(index - 1);
 }
@@ -31,11 +31,15 @@
  */
 
 #include <QMainWindow>
+#include <QImage>
+#include "maincontroller.h"
+#include "latencystatistics.h"
 class QLabel;
 class QPushButton;
+class QComboBox;
 
 namespace de { namespace bswalz { namespace olycamerarc {
-class IMainController;
+class CLiveViewDecoder;
 }}}
 
 QT_BEGIN_NAMESPACE
@@ -55,27 +59,49 @@ public:
 	QPushButton * getFocusButton()   { return m_pFocusButton; }
 	QPushButton * getShutterButton() { return m_pShutterButton; }
     QPushButton * getLifeViewButton() { return m_pLifeViewButton; }
+	QPushButton * getSequenceButton() { return m_pSequenceButton; }
+	/** Writes the LifeView latency statistics to the application data directory */
+	void dumpLatencyStatistics();
 
 protected:
+	virtual bool eventFilter(QObject *, QEvent *) override;
+
 	QLabel * m_pWifiLED;
 	QLabel * m_pOlyWifiLED;
 	QLabel * m_pLifeView;
 	QPushButton * m_pFocusButton;
 	QPushButton * m_pShutterButton;
     QPushButton * m_pLifeViewButton;
+	QPushButton * m_pSequenceButton;
+	QPushButton * m_pGalleryButton;
+	QPushButton * m_pRecordButton;
+	QComboBox * m_pLiveViewQualityBox;
+	QPushButton * m_pPeakingButton;
+	QPushButton * m_pHistogramButton;
 	QLabel * m_pShutterSpeedLabel;
 	QLabel * m_pFocalValueLabel;
 	QLabel * m_pEVLabel;
 	QLabel * m_pISOLabel;
     QLabel * m_pExpModeLabel;
     de::bswalz::olycamerarc::IMainController * m_pMainController;
+	de::bswalz::olycamerarc::CLiveViewDecoder * m_pLiveViewDecoder;
+	de::bswalz::olycamerarc::CLatencyStatistics m_LatencyStatistics;
+	de::bswalz::olycamerarc::CLiveViewFrame     m_PaintPendingFrame;
+	bool m_PaintPending;
+	bool m_LatencyOverlayEnabled;
 
 protected slots:
 	void notifyWifiStatusChanged(QVariant);
 	void notifyCameraStatusChanged(QVariant);
 	void notifyCameraValueChanged(QVariant, QVariant);
 	void notifyLifeViewImageChanged(QVariant);
+	void notifyLifeViewImageDecoded(QImage, de::bswalz::olycamerarc::CLiveViewFrame);
     void notifyLifeViewButtonChecked(bool);
+	void openGallery();
+	void liveViewQualityChanged(int);
+	void notifyRecordButtonChecked(bool);
+	void notifyPeakingButtonChecked(bool);
+	void notifyHistogramButtonChecked(bool);
 
 private:
 	Ui::MainWindow *ui;
@@ -0,0 +1,274 @@
+/**
+ * OlympusCamera-RemoteControl: monitoring of the network interfaces
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "networkmonitor.h"
+#include "tracing.h"
+#include <common/network/networkhelper.h> // Separate git-repo
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QtNetwork/QNetworkInterface>
+#include <QtNetwork/QHostAddress>
+#include <QDebug>
+
+#if defined(OLYCAMERARC_NETLINK)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CNetworkMonitor
+// -----------------------------------------------------------------------
+CNetworkMonitor::CNetworkMonitor(const std::string & cameraGateway, QObject * pParent)
+	: QObject(pParent), m_CameraGateway(cameraGateway), m_NetlinkSocket(-1), m_pNetlinkNotifier(nullptr),
+	  m_pTimer(new QTimer(this)), m_WifiStatus(-1) {
+	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(evaluate()));
+}
+
+// -----------------------------------------------------------------------
+CNetworkMonitor::~CNetworkMonitor() {
+	closeNetlink();
+}
+
+// -----------------------------------------------------------------------
+void CNetworkMonitor::start() {
+	if (openNetlink()) {
+		m_pTimer->setSingleShot(true);
+		m_pTimer->setInterval(SETTLE_TIME);
+		}
+	else {
+		qDebug("Netlink not available, network interfaces are polled");
+		m_pTimer->setSingleShot(false);
+		m_pTimer->start(POLL_INTERVAL);
+		}
+	m_WifiStatus = -1; // Emits the initial state
+	evaluate();
+}
+
+// -----------------------------------------------------------------------
+void CNetworkMonitor::stop() {
+	m_pTimer->stop();
+	closeNetlink();
+}
+
+// -----------------------------------------------------------------------
+bool CNetworkMonitor::openNetlink() {
+#if defined(OLYCAMERARC_NETLINK)
+	if (m_NetlinkSocket >= 0)
+		return true;
+	int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		return false;
+	sockaddr_nl addr = {};
+	addr.nl_family   = AF_NETLINK;
+	addr.nl_groups   = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV4_ROUTE;
+	if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+		qDebug("Netlink socket not bound: %s", strerror(errno));
+		::close(fd);
+		return false;
+		}
+	m_NetlinkSocket    = fd;
+	m_pNetlinkNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+	connect(m_pNetlinkNotifier, SIGNAL(activated(int)), this, SLOT(netlinkActivated()));
+	return true;
+#else
+	return false;
+#endif
+}
+
+// -----------------------------------------------------------------------
+void CNetworkMonitor::closeNetlink() {
+#if defined(OLYCAMERARC_NETLINK)
+	if (m_NetlinkSocket < 0)
+		return;
+	delete m_pNetlinkNotifier;
+	::close(m_NetlinkSocket);
+	m_pNetlinkNotifier = nullptr;
+	m_NetlinkSocket    = -1;
+#endif
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: drains the notifications, the evaluation follows after SETTLE_TIME
+void CNetworkMonitor::netlinkActivated() {
+#if defined(OLYCAMERARC_NETLINK)
+	char buffer[8192];
+	bool changed = false;
+	for (;;) {
+		const ssize_t size = ::recv(m_NetlinkSocket, buffer, sizeof(buffer), MSG_DONTWAIT);
+		if (size > 0) {
+			changed = true;
+			continue;
+			}
+		if (size < 0 && errno == ENOBUFS) { // Notifications lost
+			changed = true;
+			continue;
+			}
+		if (size < 0 && errno == EINTR)
+			continue;
+		break;
+		}
+	if (changed && !m_pTimer->isActive())
+		m_pTimer->start();
+#endif
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: evaluates the interfaces, emits networkChanged() on changes
+void CNetworkMonitor::evaluate() {
+	OLYCAMERARC_TRACE_SCOPE("Network evaluate");
+	std::map<int, std::string> gateways;
+	const bool perInterface = getDefaultGateways(gateways);
+
+	bool    anyWifiFound = false;
+	bool    olyWifiFound = false;
+	QString localIpAddress;
+	const QHostAddress cameraAddress(QString::fromStdString(m_CameraGateway));
+	if (cameraAddress.isLoopback()) { // Simulated camera on the local host
+		anyWifiFound   = true;
+		olyWifiFound   = true;
+		localIpAddress = cameraAddress.toString();
+		}
+	const QList<QNetworkInterface> interfaces = (olyWifiFound) ? QList<QNetworkInterface>() : QNetworkInterface::allInterfaces();
+	for (auto &interface : interfaces) {
+		if (interface.isValid() && (interface.flags() & QNetworkInterface::IsUp) > 0 &&
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+		((interface.type() == QNetworkInterface::Wifi) ||
+		 (interface.type() == QNetworkInterface::Unknown && interface.name().indexOf("wlan") >= 0))
+#else
+		 (interface.name().indexOf("wlan") >= 0)
+#endif
+			) {
+			anyWifiFound = true;
+			std::string gateway;
+			if (perInterface) {
+				auto it = gateways.find(interface.index());
+				if (it != gateways.end()) gateway = it->second;
+				}
+			else {
+				gateway = de::bswalz::network::CNetworkHelper::getDefaultGateway(); // Does not work with 2 different network cards [2024-09-09]
+				}
+			if (gateway == m_CameraGateway) {
+				const auto addresses = interface.addressEntries();
+				for (auto &entry : addresses) {
+					if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+						localIpAddress = entry.ip().toString();
+						break;
+						}
+					}
+				olyWifiFound = true;
+				break;
+				}
+			} // End if interface ist up and valid
+		} // End for all interfaces
+
+	const int status = (olyWifiFound) ? EWifiOlyCameraConnected : (anyWifiFound) ? EWifiConnected : EWifiNotConnected;
+	if (status != m_WifiStatus || localIpAddress != m_LocalIpAddress) {
+		m_WifiStatus     = status;
+		m_LocalIpAddress = localIpAddress;
+		emit networkChanged(status, localIpAddress);
+		}
+}
+
+// -----------------------------------------------------------------------
+// Dumps the IPv4 routes and collects the gateways of the default routes
+bool CNetworkMonitor::getDefaultGateways(std::map<int, std::string> & gateways) const {
+#if defined(OLYCAMERARC_NETLINK)
+	if (m_NetlinkSocket < 0)
+		return false;
+	int fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		return false;
+	timeval timeout = { 1, 0 };
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	struct {
+		nlmsghdr	header;
+		rtmsg		message;
+	} request = {};
+	request.header.nlmsg_len    = NLMSG_LENGTH(sizeof(rtmsg));
+	request.header.nlmsg_type   = RTM_GETROUTE;
+	request.header.nlmsg_flags  = NLM_F_REQUEST | NLM_F_DUMP;
+	request.header.nlmsg_seq    = 1;
+	request.message.rtm_family  = AF_INET;
+	if (::send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+		::close(fd);
+		return false;
+		}
+
+	char buffer[16384];
+	bool done = false, ok = true;
+	while (!done && ok) {
+		ssize_t size = ::recv(fd, buffer, sizeof(buffer), 0);
+		if (size <= 0) {
+			ok = false;
+			break;
+			}
+		int length = (int)size;
+		for (nlmsghdr * pHeader = (nlmsghdr*)buffer; NLMSG_OK(pHeader, length); pHeader = NLMSG_NEXT(pHeader, length)) {
+			if (pHeader->nlmsg_type == NLMSG_DONE)	{ done = true; break; }
+			if (pHeader->nlmsg_type == NLMSG_ERROR)	{ ok = false; break; }
+			if (pHeader->nlmsg_type != RTM_NEWROUTE)
+				continue;
+			const rtmsg * pRoute = (const rtmsg*)NLMSG_DATA(pHeader);
+			if (pRoute->rtm_family != AF_INET || pRoute->rtm_dst_len != 0) // Default routes only
+				continue;
+			int     outputInterface = -1;
+			in_addr gateway         = {};
+			bool    hasGateway      = false;
+			int     attributeLength = RTM_PAYLOAD(pHeader);
+			for (const rtattr * pAttribute = RTM_RTA(pRoute); RTA_OK(pAttribute, attributeLength); pAttribute = RTA_NEXT(pAttribute, attributeLength)) {
+				if (pAttribute->rta_type == RTA_OIF)
+					outputInterface = *(const int*)RTA_DATA(pAttribute);
+				else if (pAttribute->rta_type == RTA_GATEWAY) {
+					memcpy(&gateway, RTA_DATA(pAttribute), sizeof(gateway));
+					hasGateway = true;
+					}
+				}
+			char text[INET_ADDRSTRLEN];
+			if (hasGateway && outputInterface > 0 && inet_ntop(AF_INET, &gateway, text, sizeof(text)) != nullptr)
+				gateways.insert(std::make_pair(outputInterface, std::string(text))); // First route wins
+			}
+		}
+	::close(fd);
+	return ok;
+#else
+	Q_UNUSED(gateways)
+	return false;
+#endif
+}
+
+}}} // End namespaces
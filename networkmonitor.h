@@ -0,0 +1,94 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_NETWORKMONITOR_H
+#define DE_BSWALZ_OLYCAMERARC_NETWORKMONITOR_H
+
+/**
+ * OlympusCamera-RemoteControl: monitoring of the network interfaces
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "types.h"
+#include <QObject>
+#include <QString>
+#include <map>
+#include <string>
+
+#if defined(Q_OS_LINUX)
+#define OLYCAMERARC_NETLINK		// Change notifications of interfaces, addresses and routes by RTNETLINK
+#endif
+
+class QSocketNotifier;
+class QTimer;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CNetworkMonitor
+// Detects the Wifi of the camera: an interface which is up and whose
+// default route points to the camera. On Linux the interfaces are evaluated
+// on RTNETLINK notifications only and the route is resolved per interface.
+// Otherwise (or if netlink is not available) they are polled. A camera on
+// the loopback interface (simulator) is always connected.
+// -----------------------------------------------------------------------
+class CNetworkMonitor : public QObject {
+	Q_OBJECT
+public:
+	static const int POLL_INTERVAL = 2000;	// ms, without netlink
+	static const int SETTLE_TIME   =   20;	// ms, coalesces bursts of notifications
+
+	CNetworkMonitor(const std::string & cameraGateway, QObject * pParent = nullptr);
+	virtual ~CNetworkMonitor();
+	/** Starts monitoring, networkChanged() is emitted with the initial state */
+	void	start();
+	void	stop();
+	/** True if notified by netlink, false if polling */
+	bool	isEventDriven() const { return m_NetlinkSocket >= 0; }
+
+signals:
+	/** EWifiStatus and local IPv4 address of the camera's network (empty if not connected) */
+	void	networkChanged(int, QString);
+
+protected slots:
+	void	netlinkActivated();
+	void	evaluate();
+
+private:
+	bool	openNetlink();
+	void	closeNetlink();
+	/** Default gateway of each interface index, false if not available */
+	bool	getDefaultGateways(std::map<int, std::string> &) const;
+
+	std::string			m_CameraGateway;
+	int					m_NetlinkSocket;
+	QSocketNotifier *	m_pNetlinkNotifier;
+	QTimer *			m_pTimer;
+	int					m_WifiStatus;
+	QString				m_LocalIpAddress;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_NETWORKMONITOR_H
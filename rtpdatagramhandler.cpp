@@ -0,0 +1,292 @@
+/**
+ * OlympusCamera-RemoteControl: reassembly of LiveView images from RTP packets
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "rtpdatagramhandler.h"
+#include "latencystatistics.h"
+#include "liveviewrecorder.h"
+#include "tracing.h"
+#include <string.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CFrameBufferPool
+// -----------------------------------------------------------------------
+CFrameBufferPool::CFrameBufferPool(unsigned int count) : m_Next(0), m_Capacity(0) {
+	for (unsigned int i = 0; i < count; i++)
+		m_Buffers.emplace_back(new CFrameBuffer());
+}
+
+// -----------------------------------------------------------------------
+CFrameBuffer * CFrameBufferPool::acquire() {
+	const unsigned int count = m_Buffers.size();
+	for (unsigned int i = 0; i < count; i++) {
+		CFrameBuffer * pBuffer = m_Buffers[(m_Next + i) % count].get();
+		// A buffer is free if it is neither queued nor shared with a consumer (e.g. the GUI)
+		if (pBuffer->m_InUse || !(pBuffer->m_Data.isNull() || pBuffer->m_Data.isDetached()))
+			continue;
+		if (pBuffer->m_Data.capacity() < m_Capacity)
+			pBuffer->m_Data.reserve(m_Capacity);	// Only on first use or after changing "lvqty"
+		pBuffer->m_Data.resize(0);					// Keeps the reserved capacity
+		pBuffer->m_InUse = true;
+		m_Next = (m_Next + i + 1) % count;
+		return pBuffer;
+		}
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------
+void CFrameBufferPool::release(CFrameBuffer * pBuffer) {
+	if (pBuffer != nullptr)
+		pBuffer->m_InUse = false;
+}
+
+
+// -----------------------------------------------------------------------
+// Class CRTPDatagramHandler
+// -----------------------------------------------------------------------
+CRTPDatagramHandler::CRTPDatagramHandler()
+	: mvc::Model("RTPDatagramHandler"), m_Pool(POOL_SIZE),
+	  m_pPartialFrame(nullptr), m_PartialFrameCorrupt(false), m_PartialFrameDropped(false), m_PayloadNumber(0uL),
+	  m_SequenceInitialized(false), m_ExpectedSequenceNumber(0), m_HighestSequenceNumber(0), m_HeldPacketCount(0),
+	  m_HeldPayloads(REORDER_WINDOW * REORDER_SLOT_SIZE), m_pRecorder(nullptr) {
+	setLiveViewQuality(ELVQ_0320x0240);
+}
+
+// -----------------------------------------------------------------------
+QSize CRTPDatagramHandler::getFrameSize(ELiveViewQuality quality) {
+	switch (quality) {
+		case ELVQ_0640x0480 :	return QSize( 640, 480);
+		case ELVQ_0800x0600 :	return QSize( 800, 600);
+		case ELVQ_1024x0768 :	return QSize(1024, 768);
+		case ELVQ_1280x0960 :	return QSize(1280, 960);
+		default:				return QSize( 320, 240);
+		}
+}
+
+// -----------------------------------------------------------------------
+void CRTPDatagramHandler::setLiveViewQuality(ELiveViewQuality quality) {
+	// Estimated upper limit of a LiveView JPEG: 2 bits per pixel.
+	// Larger images are still processed, the buffer then grows once and keeps its size.
+	const QSize size = getFrameSize(quality);
+	m_Pool.setCapacity(size.width() * size.height() / 4);
+}
+
+// -----------------------------------------------------------------------
+void CRTPDatagramHandler::processDatagram(const QByteArray & data) {
+	processDatagram((const u_int8_t*)data.constData(), data.size());
+}
+
+// -----------------------------------------------------------------------
+void CRTPDatagramHandler::processDatagram(const u_int8_t * pData, int size0) {
+	OLYCAMERARC_TRACE_SCOPE("processDatagram");
+	bool   headerInitialized = false;
+	u_int16_t sequenceNumber = 0;
+	u_int8_t      CSRC_Count = 0;
+	bool             padding = false, extension = false, marker = false;
+
+	// Decodes an RTP packet and extracts marker, sequence number, and (partial) payload
+	// The payload is part of several RTP packets.
+	// Based on: https://en.wikipedia.org/wiki/Real-time_Transport_Protocol
+	if (size0 > 0) {
+		padding		= (*(pData + 0) & 0x20) >> 5;
+		extension	= (*(pData + 0) & 0x10) >> 4;
+		CSRC_Count  = (*(pData + 0) & 0x0F);
+		}
+	if (size0 > 1) {
+		marker		= (*(pData + 1) & 0x80) >> 7;
+		}
+	if (size0 > 3) {
+		sequenceNumber    = (*(pData + 2) << 8) + *(pData + 3);
+		headerInitialized = true;
+		}
+
+	if (headerInitialized) {
+		u_int32_t payloadStart = 12 + 4*CSRC_Count; // Calculated without extension header
+		if (extension && (int)payloadStart + 4 <= size0) {
+			u_int16_t extHeaderLen = (*(pData + payloadStart + 2) << 8) + *(pData + payloadStart + 3);
+			payloadStart += (4 * extHeaderLen + 4 /* fields of header ID and length */);
+			}
+
+		u_int16_t amountPadding = (padding) ? *(pData + size0 - 1) : 0;
+		int         payloadSize = size0 - (int)payloadStart - amountPadding;
+		processPacket(sequenceNumber, pData + payloadStart, (payloadSize > 0) ? payloadSize : 0, marker);
+		}
+}
+
+// -----------------------------------------------------------------------
+// Passes the payloads in the order of their sequence numbers to appendPayload().
+// Packets ahead of the expected one are held until the gap is closed or the
+// reorder window is exceeded. Then the missing packets are counted as lost.
+void CRTPDatagramHandler::processPacket(u_int16_t sequenceNumber, const u_int8_t * pPayload, int payloadSize, bool marker) {
+	m_Statistics.receivedPackets++;
+	int diff = (int16_t)(u_int16_t)(sequenceNumber - m_ExpectedSequenceNumber);
+	if (!m_SequenceInitialized || diff > MAX_DROPOUT || diff < -MAX_DROPOUT) {
+		// First packet or restarted stream (e.g. new "startliveview"): the first frame may be fractional
+		for (auto & held : m_HeldPackets) held.valid = false;
+		m_HeldPacketCount        = 0;
+		m_Pool.release(m_pPartialFrame);
+		m_pPartialFrame          = nullptr;
+		m_PartialFrameCorrupt    = false;
+		m_PartialFrameDropped    = false;
+		m_PayloadNumber          = 0;
+		m_ExpectedSequenceNumber = sequenceNumber;
+		m_HighestSequenceNumber  = sequenceNumber;
+		m_SequenceInitialized    = true;
+		}
+	if ((int16_t)(u_int16_t)(sequenceNumber - m_HighestSequenceNumber) > 0)
+		m_HighestSequenceNumber = sequenceNumber;
+	else if (sequenceNumber != m_HighestSequenceNumber && (int16_t)(u_int16_t)(sequenceNumber - m_ExpectedSequenceNumber) >= 0)
+		m_Statistics.reorderedPackets++;	// Arrived after a successor, but still in time
+
+	for (;;) {
+		diff = (int16_t)(u_int16_t)(sequenceNumber - m_ExpectedSequenceNumber);
+		if (diff < 0) {							// Already skipped or duplicate
+			m_Statistics.latePackets++;
+			return;
+			}
+		if (diff == 0) {						// In order
+			appendPayload(pPayload, payloadSize, marker);
+			m_ExpectedSequenceNumber++;
+			releaseHeldPackets();
+			return;
+			}
+		if (diff < (int)REORDER_WINDOW) {		// Ahead, within the window
+			holdPacket(sequenceNumber, pPayload, payloadSize, marker);
+			return;
+			}
+		skipMissingPacket();					// Beyond the window, gives up the oldest missing packet
+		}
+}
+
+// -----------------------------------------------------------------------
+void CRTPDatagramHandler::holdPacket(u_int16_t sequenceNumber, const u_int8_t * pPayload, int payloadSize, bool marker) {
+	CHeldPacket & held = m_HeldPackets[sequenceNumber % REORDER_WINDOW];
+	if (held.valid) {							// Duplicate
+		m_Statistics.latePackets++;
+		return;
+		}
+	held.oversize = (payloadSize > REORDER_SLOT_SIZE);	// Larger than any received datagram, e.g. of a replay
+	if (held.oversize)
+		m_Statistics.oversizePackets++;
+	else
+		memcpy(m_HeldPayloads.data() + (sequenceNumber % REORDER_WINDOW) * REORDER_SLOT_SIZE, pPayload, payloadSize);
+	held.valid          = true;
+	held.marker         = marker;
+	held.sequenceNumber = sequenceNumber;
+	held.size           = payloadSize;
+	m_HeldPacketCount++;
+}
+
+// -----------------------------------------------------------------------
+// Appends the held packets following the expected sequence number
+void CRTPDatagramHandler::releaseHeldPackets() {
+	while (m_HeldPacketCount > 0) {
+		const unsigned int slot = m_ExpectedSequenceNumber % REORDER_WINDOW;
+		CHeldPacket & held = m_HeldPackets[slot];
+		if (!held.valid || held.sequenceNumber != m_ExpectedSequenceNumber)
+			break;
+		held.valid = false;
+		m_HeldPacketCount--;
+		if (held.oversize)
+			m_PartialFrameCorrupt = true;
+		appendPayload(m_HeldPayloads.data() + slot * REORDER_SLOT_SIZE, held.oversize ? 0 : held.size, held.marker);
+		m_ExpectedSequenceNumber++;
+		}
+}
+
+// -----------------------------------------------------------------------
+// The expected packet is lost, the frame containing it is incomplete
+void CRTPDatagramHandler::skipMissingPacket() {
+	m_Statistics.lostPackets++;
+	m_PartialFrameCorrupt = true;
+	m_ExpectedSequenceNumber++;
+	releaseHeldPackets();
+}
+
+// -----------------------------------------------------------------------
+void CRTPDatagramHandler::appendPayload(const u_int8_t * pPayload, int payloadSize, bool marker) {
+	if (m_pPartialFrame == nullptr && !m_PartialFrameCorrupt && !m_PartialFrameDropped) {
+		m_pPartialFrame = m_Pool.acquire(); // nullptr: all buffers in use, the frame gets lost
+		if (m_pPartialFrame == nullptr) {
+			m_PartialFrameDropped = true;	// Counted once per frame, not per packet
+			m_Statistics.droppedFrames++;
+			}
+		else {
+			m_pPartialFrame->m_FirstPacketTime = CLatencyClock::now();
+			}
+		}
+	if (m_pPartialFrame != nullptr && !m_PartialFrameCorrupt && payloadSize > 0)
+		m_pPartialFrame->m_Data.append((const char*)pPayload, payloadSize);
+
+	if (marker) {
+		completeFrame();
+		m_PayloadNumber++;
+		}
+}
+
+// -----------------------------------------------------------------------
+void CRTPDatagramHandler::completeFrame() {
+	CFrameBuffer * pFrame = m_pPartialFrame;
+	const bool    corrupt = m_PartialFrameCorrupt;
+	m_pPartialFrame       = nullptr;
+	m_PartialFrameCorrupt = false;
+	m_PartialFrameDropped = false;
+
+	if (m_PayloadNumber == 0) {	// The first partialPayload may be a fractional payload
+		m_Pool.release(pFrame);
+		return;
+		}
+	if (corrupt) {
+		m_Statistics.incompleteFrames++;
+		m_Pool.release(pFrame);
+		return;
+		}
+	if (pFrame == nullptr)
+		return;
+
+	OLYCAMERARC_TRACE_INSTANT("Frame complete");
+	pFrame->m_Number       = m_PayloadNumber;
+	pFrame->m_CompleteTime = CLatencyClock::now();
+	m_Statistics.completeFrames++;
+	CLiveViewRecorder * pRecorder = m_pRecorder;
+	if (pRecorder != nullptr) // Copies the frame, does not wait for the disk
+		pRecorder->addFrame((const u_int8_t*)pFrame->m_Data.constData(), pFrame->m_Data.size(), pFrame->m_CompleteTime);
+	CFrameBuffer * pReplaced = m_Mailbox.publish(pFrame);
+	if (pReplaced != nullptr) {		// Not yet displayed, the consumer has already been notified
+		m_Statistics.supersededFrames++;
+		m_Pool.release(pReplaced);
+		}
+	else {
+		mvc::Model::setChanged();
+		mvc::Model::notifyAll();
+		}
+}
+
+}}} // End namespaces
@@ -0,0 +1,200 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_RTPDATAGRAMHANDLER_H
+#define DE_BSWALZ_OLYCAMERARC_RTPDATAGRAMHANDLER_H
+
+/**
+ * OlympusCamera-RemoteControl: reassembly of LiveView images from RTP packets
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "types.h"
+#include <QByteArray>
+#include <QSize>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+#include <common/mvc/Model.h>		// Separate git-repo
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+class CLiveViewRecorder;
+
+// -----------------------------------------------------------------------
+// Class CFrameBuffer
+// A reusable buffer of the frame buffer pool holding one LiveView image.
+// -----------------------------------------------------------------------
+class CFrameBuffer {
+	friend class CFrameBufferPool;
+	friend class CRTPDatagramHandler;
+public:
+	/** JPEG data of the image. Consumers may keep a (shallow) copy, the
+	 *  buffer is not reused as long as the copy exists. */
+	const QByteArray & getData() const { return m_Data; }
+	u_int32_t	getNumber() const { return m_Number; }
+	/** Arrival of the first and the last (marker) packet, CLatencyClock */
+	int64_t		getFirstPacketTime() const { return m_FirstPacketTime; }
+	int64_t		getCompleteTime() const { return m_CompleteTime; }
+private:
+	CFrameBuffer() : m_Number(0uL), m_FirstPacketTime(0), m_CompleteTime(0), m_InUse(false) {}
+	QByteArray			m_Data;
+	u_int32_t			m_Number;
+	int64_t				m_FirstPacketTime;
+	int64_t				m_CompleteTime;
+	std::atomic<bool>	m_InUse;
+};
+
+// -----------------------------------------------------------------------
+// Class CFrameBufferPool
+// Fixed ring of frame buffers. The capacity of the buffers is reserved
+// once (on first use) and then reused, so there are no allocations per frame.
+// -----------------------------------------------------------------------
+class CFrameBufferPool {
+public:
+	CFrameBufferPool(unsigned int count);
+	/** Sets the capacity of each buffer in bytes, applied on next acquire() */
+	void	setCapacity(int capacity) { m_Capacity = capacity; }
+	int		getCapacity() const { return m_Capacity; }
+	/** Returns an empty buffer or nullptr if all buffers are in use */
+	CFrameBuffer * acquire();
+	/** Returns the buffer to the pool */
+	void	release(CFrameBuffer *);
+private:
+	std::vector<std::unique_ptr<CFrameBuffer>> m_Buffers;
+	unsigned int		m_Next;
+	int					m_Capacity;
+};
+
+// -----------------------------------------------------------------------
+// Class CLatestFrameMailbox
+// Single, lock-free slot between the reassembly (producer) and the display
+// (consumer). A new frame replaces a frame not yet taken by the consumer.
+// -----------------------------------------------------------------------
+class CLatestFrameMailbox {
+public:
+	CLatestFrameMailbox() : m_pFrame(nullptr) {}
+	/** Returns the replaced frame, nullptr if the consumer has taken the previous one */
+	CFrameBuffer * publish(CFrameBuffer * pFrame) { return m_pFrame.exchange(pFrame, std::memory_order_acq_rel); }
+	/** Returns the latest frame or nullptr */
+	CFrameBuffer * take() { return m_pFrame.exchange(nullptr, std::memory_order_acq_rel); }
+private:
+	std::atomic<CFrameBuffer*>	m_pFrame;
+};
+
+// -----------------------------------------------------------------------
+// Class CRTPStatistics
+// Counters of a LiveView stream
+// -----------------------------------------------------------------------
+class CRTPStatistics {
+public:
+	CRTPStatistics() : receivedPackets(0), lostPackets(0), reorderedPackets(0), latePackets(0),
+					   oversizePackets(0), completeFrames(0), incompleteFrames(0), droppedFrames(0), supersededFrames(0) {}
+	/** Lost packets in percent of the expected packets */
+	double		getLossPercent() const {
+		const u_int32_t expected = receivedPackets + lostPackets;
+		return (expected > 0) ? 100.0 * lostPackets / expected : 0.0;
+		}
+	u_int32_t	receivedPackets;
+	u_int32_t	lostPackets;		// Never arrived within the reorder window
+	u_int32_t	reorderedPackets;	// Arrived out of order, but within the reorder window
+	u_int32_t	latePackets;		// Arrived after being counted as lost, or duplicates
+	u_int32_t	oversizePackets;	// Arrived out of order, too large to be held (not lost)
+	u_int32_t	completeFrames;
+	u_int32_t	incompleteFrames;	// Dropped due to lost packets
+	u_int32_t	droppedFrames;		// Dropped due to no free buffer
+	u_int32_t	supersededFrames;	// Replaced by a newer frame before being displayed
+};
+
+// -----------------------------------------------------------------------
+// Class CRTPDatagramHandler
+// Packets are reordered by their sequence number within REORDER_WINDOW
+// packets. Frames with missing packets are dropped and never reach the decoder.
+// Complete frames are published to a CLatestFrameMailbox, the model notifies
+// its views when the mailbox was empty, i.e. the consumer has to take a frame.
+// -----------------------------------------------------------------------
+class CRTPDatagramHandler : public mvc::Model {
+public:
+	static const unsigned int POOL_SIZE          = 8;		// Partial, published and decoded frames
+	static const unsigned int REORDER_WINDOW     = 16;		// Packets
+	static const int          MAX_DATAGRAM_SIZE  = 16 * 1024;	// Received by CLiveViewReceiver
+	static const int          REORDER_SLOT_SIZE  = MAX_DATAGRAM_SIZE;	// Max. payload of a held packet
+	static const int          MAX_DROPOUT        = 3000;	// Larger jumps restart the sequence
+
+	CRTPDatagramHandler();
+	virtual ~CRTPDatagramHandler() {}
+	/** Adapts the frame buffers to the negotiated "lvqty" */
+	void	setLiveViewQuality(ELiveViewQuality);
+	void	processDatagram(const QByteArray &);
+	void	processDatagram(const u_int8_t *, int);
+	/** Takes the latest completed frame, nullptr if there is none. The frame has to
+	 *  be returned by releaseFrame(). Both may be called from any thread. */
+	CFrameBuffer * takeFrame() { return m_Mailbox.take(); }
+	void	releaseFrame(CFrameBuffer * pFrame) { m_Pool.release(pFrame); }
+	/** Statistics, to be accessed by the thread processing the datagrams */
+	const CRTPStatistics & getStatistics() const { return m_Statistics; }
+	void	resetStatistics() { m_Statistics = CRTPStatistics(); }
+	/** Each complete frame is passed to the recorder, nullptr: none. May be called from any thread. */
+	void	setRecorder(CLiveViewRecorder * pRecorder) { m_pRecorder = pRecorder; }
+
+	/** Pixel size of a LiveView image of the given quality */
+	static QSize getFrameSize(ELiveViewQuality);
+private:
+	void	processPacket(u_int16_t sequenceNumber, const u_int8_t * pPayload, int payloadSize, bool marker);
+	void	holdPacket(u_int16_t sequenceNumber, const u_int8_t * pPayload, int payloadSize, bool marker);
+	void	releaseHeldPackets();
+	void	skipMissingPacket();
+	void	appendPayload(const u_int8_t * pPayload, int payloadSize, bool marker);
+	void	completeFrame();
+
+	class CHeldPacket {
+	public:
+		CHeldPacket() : valid(false), marker(false), oversize(false), sequenceNumber(0), size(0) {}
+		bool		valid;
+		bool		marker;
+		bool		oversize;	// Payload not stored, the frame is incomplete
+		u_int16_t	sequenceNumber;
+		int			size;
+	};
+
+	CFrameBufferPool	m_Pool;
+	CFrameBuffer *		m_pPartialFrame;
+	bool				m_PartialFrameCorrupt;
+	bool				m_PartialFrameDropped;	// No free buffer for the current frame
+	CLatestFrameMailbox	m_Mailbox;
+	u_int32_t			m_PayloadNumber;
+	bool				m_SequenceInitialized;
+	u_int16_t			m_ExpectedSequenceNumber;
+	u_int16_t			m_HighestSequenceNumber;
+	CHeldPacket			m_HeldPackets[REORDER_WINDOW];
+	unsigned int		m_HeldPacketCount;
+	std::vector<u_int8_t> m_HeldPayloads;			// REORDER_WINDOW * REORDER_SLOT_SIZE
+	CRTPStatistics		m_Statistics;
+	std::atomic<CLiveViewRecorder*> m_pRecorder;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_RTPDATAGRAMHANDLER_H
@@ -0,0 +1,378 @@
+/**
+ * OlympusCamera-RemoteControl: simulator of the camera's HTTP interface
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "camerasimulator.h"
+#include "liveviewstreamer.h"
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QDateTime>
+#include <QFile>
+#include <QTimer>
+#include <QUrl>
+#include <QDebug>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Minimal command list if no file is given
+// -----------------------------------------------------------------------
+const char * const DEFAULT_COMMAND_LIST =
+	"<?xml version=\"1.0\"?><oishare><version>4.10</version>"
+	"<cgi name=\"get_commandlist\"><http_method type=\"get\"/></cgi>"
+	"<cgi name=\"switch_cammode\"><http_method type=\"get\"><cmd1 name=\"mode\"><param1 name=\"rec\"><cmd2 name=\"lvqty\">"
+	"<param2 name=\"0320x0240\"/><param2 name=\"0640x0480\"/><param2 name=\"0800x0600\"/><param2 name=\"1024x0768\"/><param2 name=\"1280x0960\"/>"
+	"</cmd2></param1><param1 name=\"play\"/><param1 name=\"shutter\"/></cmd1></http_method></cgi>"
+	"<cgi name=\"exec_takemisc\"><http_method type=\"get\"><cmd1 name=\"com\"><param1 name=\"startliveview\"><cmd2 name=\"port\"/></param1>"
+	"<param1 name=\"stopliveview\"/><param1 name=\"getrecview\"/><param1 name=\"getlastjpg\"/></cmd1></http_method></cgi>"
+	"<cgi name=\"get_camprop\"><http_method type=\"get\"><cmd1 name=\"com\"><param1 name=\"desc\"><cmd2 name=\"propname\">"
+	"<param2 name=\"takemode\"/><param2 name=\"focalvalue\"/><param2 name=\"expcomp\"/><param2 name=\"shutspeedvalue\"/>"
+	"<param2 name=\"isospeedvalue\"/><param2 name=\"wbvalue\"/><param2 name=\"cameradrivemode\"/><param2 name=\"desclist\"/>"
+	"</cmd2></param1></cmd1></http_method></cgi>"
+	"<cgi name=\"exec_shutter\"><http_method type=\"get\"><cmd1 name=\"com\"><param1 name=\"1stpush\"/><param1 name=\"2ndpush\"/>"
+	"<param1 name=\"1st2ndpush\"/><param1 name=\"2nd1strelease\"/><param1 name=\"2ndrelease\"/><param1 name=\"1strelease\"/></cmd1></http_method></cgi>"
+	"</oishare>";
+
+// -----------------------------------------------------------------------
+// Class CCameraSimulator
+// -----------------------------------------------------------------------
+CCameraSimulator::CCameraSimulator(const CSimulatorConfig & config, QObject * pParent)
+	: QObject(pParent), m_Config(config), m_pServer(new QTcpServer(this)), m_pPropertyTimer(new QTimer(this)),
+	  m_pLiveViewStreamer(new CLiveViewStreamer(this)), m_CameraMode("play"), m_LiveViewQuality("0640x0480"),
+	  m_Random(std::random_device()()), m_Requests(0), m_AcceptedConnections(0),
+	  m_Images(config.images) {
+	const struct { const char * name; const char * attribute; const char * value; const char * enumValues; } PROPERTIES[] = {
+		{ "takemode",        "getset", "M",       "iAuto P A S M ART movie" },
+		{ "focalvalue",      "getset", "5.6",     "2.8 3.2 3.5 4.0 4.5 5.0 5.6 6.3 7.1 8.0 9.0 10 11 13 14 16 18 20 22" },
+		{ "expcomp",         "getset", "0.0",     "-3.0 -2.7 -2.3 -2.0 -1.7 -1.3 -1.0 -0.7 -0.3 0.0 +0.3 +0.7 +1.0 +1.3 +1.7 +2.0 +2.3 +2.7 +3.0" },
+		{ "shutspeedvalue",  "getset", "250",     "60\" 30\" 15\" 8\" 4\" 2\" 1\" 2 4 8 15 30 60 125 250 500 1000 2000 4000" },
+		{ "isospeedvalue",   "getset", "Auto",    "Auto Low 200 250 320 400 500 640 800 1000 1250 1600 3200 6400" },
+		{ "wbvalue",         "getset", "0",       "0 18 16 17 20 35 64 23 256 257 258 259 512" },
+		{ "cameradrivemode", "getset", "normal",  "normal continuous-H continuous-L selftimer customselftimer" } };
+	for (const auto & property : PROPERTIES) {
+		CProperty & entry = m_Properties[property.name];
+		entry.attribute  = property.attribute;
+		entry.value      = property.value;
+		entry.enumValues = property.enumValues;
+		}
+	m_pLiveViewStreamer->setFrameRate(m_Config.liveViewFps);
+	m_pLiveViewStreamer->setLossRate(m_Config.liveViewLossRate);
+	connect(m_pServer, SIGNAL(newConnection()), this, SLOT(newConnection()));
+	connect(m_pPropertyTimer, SIGNAL(timeout()), this, SLOT(changeProperties()));
+}
+
+// -----------------------------------------------------------------------
+CCameraSimulator::~CCameraSimulator() {
+}
+
+// -----------------------------------------------------------------------
+bool CCameraSimulator::start() {
+	if (!m_pServer->listen(QHostAddress::Any, m_Config.httpPort)) {
+		qWarning("Simulator: port %u not available: %s", m_Config.httpPort, qPrintable(m_pServer->errorString()));
+		return false;
+		}
+	if (m_Config.propertyChangeInterval > 0)
+		m_pPropertyTimer->start(m_Config.propertyChangeInterval);
+	qDebug("Simulator: listening on port %u, latency %d ms, jitter %d ms, errors %.1f %%",
+		   m_pServer->serverPort(), m_Config.latency, m_Config.jitter, m_Config.errorRate);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+quint16 CCameraSimulator::getPort() const {
+	return m_pServer->serverPort();
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CCameraSimulator::newConnection() {
+	while (QTcpSocket * pSocket = m_pServer->nextPendingConnection()) {
+		m_AcceptedConnections++;
+		CConnection & connection = m_Connections[pSocket];
+		connection.pTimer = new QTimer(pSocket);
+		connection.pTimer->setSingleShot(true);
+		connect(connection.pTimer, SIGNAL(timeout()), this, SLOT(sendDueReplies()));
+		connect(pSocket, SIGNAL(readyRead()), this, SLOT(readyRead()));
+		connect(pSocket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+		}
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: splits the received data into requests (GET only, no body)
+void CCameraSimulator::readyRead() {
+	QTcpSocket * pSocket = qobject_cast<QTcpSocket*>(sender());
+	if (pSocket == nullptr || !m_Connections.contains(pSocket))
+		return;
+	CConnection & connection = m_Connections[pSocket];
+	connection.buffer.append(pSocket->readAll());
+	int end;
+	while ((end = connection.buffer.indexOf("\r\n\r\n")) >= 0) {
+		const QByteArray header = connection.buffer.left(end);
+		connection.buffer.remove(0, end + 4);
+		const QList<QByteArray> requestLine = header.left(header.indexOf("\r\n")).split(' ');
+		if (requestLine.size() >= 2)
+			processRequest(pSocket, requestLine[0], requestLine[1]);
+		}
+}
+
+// -----------------------------------------------------------------------
+// Qt slot
+void CCameraSimulator::disconnected() {
+	QTcpSocket * pSocket = qobject_cast<QTcpSocket*>(sender());
+	if (m_Connections.contains(pSocket))
+		qDebug("Simulator: connection closed after %llu requests (%llu requests, %llu connections in total)",
+			   (unsigned long long)m_Connections[pSocket].requests, (unsigned long long)m_Requests, (unsigned long long)m_AcceptedConnections);
+	m_Connections.remove(pSocket);
+	if (pSocket != nullptr)
+		pSocket->deleteLater();
+}
+
+// -----------------------------------------------------------------------
+void CCameraSimulator::processRequest(QTcpSocket * pSocket, const QByteArray & method, const QByteArray & target) {
+	m_Requests++;
+	const QUrl url(QString::fromLatin1(target));
+	QString cgi = url.path();
+	if (cgi.startsWith('/'))		cgi.remove(0, 1);
+	if (cgi.endsWith(".cgi"))		cgi.chop(4);
+
+	emit requestReceived(url.query().isEmpty() ? cgi : cgi + "?" + url.query());
+
+	int        status = 200;
+	QByteArray contentType("text/plain");
+	QByteArray body;
+	if (std::uniform_real_distribution<double>(0.0, 100.0)(m_Random) < m_Config.errorRate)
+		status = 503;
+	else if (method != "GET")
+		status = 405;
+	else
+		body = handle(pSocket, cgi, QUrlQuery(url), status, contentType);
+
+	// Replies in the order of the requests, a reply is not sent before its predecessor
+	CConnection & connection = m_Connections[pSocket];
+	qint64 delay = m_Config.latency;
+	if (m_Config.jitter > 0)
+		delay += std::uniform_int_distribution<int>(0, m_Config.jitter)(m_Random);
+	if (connection.requests++ == 0)
+		delay += m_Config.acceptDelay;
+
+	qint64 dueTime = QDateTime::currentMSecsSinceEpoch() + delay;
+	if (!connection.replies.empty() && connection.replies.back().dueTime > dueTime)
+		dueTime = connection.replies.back().dueTime;
+	connection.replies.push_back(CReply(dueTime, createReply(status, contentType, body)));
+	sendDueReplies();
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: sends the replies whose time has come, restarts the timers
+void CCameraSimulator::sendDueReplies() {
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	for (auto it = m_Connections.begin(); it != m_Connections.end(); ++it) {
+		CConnection & connection = it.value();
+		while (!connection.replies.empty() && connection.replies.front().dueTime <= now) {
+			it.key()->write(connection.replies.front().data);
+			connection.replies.pop_front();
+			}
+		if (!connection.replies.empty() && !connection.pTimer->isActive())
+			connection.pTimer->start((int)(connection.replies.front().dueTime - now));
+		}
+}
+
+// -----------------------------------------------------------------------
+// One directory /DCIM/100OLYMP, the file size is an estimate
+QByteArray CCameraSimulator::getImageList(const QString & dir) const {
+	QByteArray list("VER_100\r\n");
+	if (dir == "/DCIM") {
+		list += "/DCIM,100OLYMP,0,16,20833,0\r\n";
+		}
+	else if (dir == "/DCIM/100OLYMP") {
+		for (int index = 0; index < m_Images; index++)
+			list += QString("/DCIM/100OLYMP,P%1.JPG,%2,0,20833,%3\r\n").arg(1010001 + index).arg(4000000 + index).arg(index).toLatin1();
+		}
+	return list;
+}
+
+// -----------------------------------------------------------------------
+int CCameraSimulator::getImageIndex(const QString & path) const {
+	if (!path.startsWith("/DCIM/100OLYMP/P") || !path.endsWith(".JPG"))
+		return -1;
+	bool ok = false;
+	const int index = path.mid(16, path.length() - 20).toInt(&ok) - 1010001;
+	return (ok && index >= 0 && index < m_Images) ? index : -1;
+}
+
+// -----------------------------------------------------------------------
+QByteArray CCameraSimulator::handle(QTcpSocket * pSocket, const QString & cgi, const QUrlQuery & query, int & status, QByteArray & contentType) {
+	if (cgi == "get_commandlist") {
+		contentType = "text/xml";
+		return getCommandList();
+		}
+	if (cgi == "switch_cammode") {
+		const QString mode = query.queryItemValue("mode");
+		if (mode != "rec" && mode != "play" && mode != "shutter") {
+			status = 400;
+			return QByteArray();
+			}
+		m_CameraMode = mode;
+		if (mode == "rec" && query.hasQueryItem("lvqty")) {
+			if (CLiveViewStreamer::getFrameSize(query.queryItemValue("lvqty")).isEmpty()) {
+				status = 400;
+				return QByteArray();
+				}
+			m_LiveViewQuality = query.queryItemValue("lvqty");
+			m_pLiveViewStreamer->setFrameSize(CLiveViewStreamer::getFrameSize(m_LiveViewQuality));
+			}
+		if (mode != "rec")
+			m_pLiveViewStreamer->stop();
+		return QByteArray();
+		}
+	if (cgi == "exec_shutter") {
+		const QString command = query.queryItemValue("com");
+		if (m_CameraMode != "shutter" && m_CameraMode != "rec")
+			status = 520; // Like the camera: not in recording mode
+		else if (command != "1stpush" && command != "2ndpush" && command != "1st2ndpush" &&
+				 command != "2nd1strelease" && command != "2ndrelease" && command != "1strelease")
+			status = 400;
+		else if (command == "2ndpush" || command == "1st2ndpush")
+			m_Images++;
+		return QByteArray();
+		}
+	if (cgi == "get_imglist" || cgi == "get_thumbnail" || cgi == "get_screennail" || cgi == "get_resizeimg" || cgi.startsWith("DCIM/")) {
+		if (m_CameraMode != "play") {
+			status = 520;
+			return QByteArray();
+			}
+		if (cgi == "get_imglist")
+			return getImageList(query.queryItemValue("DIR"));
+		const int index = getImageIndex(cgi.startsWith("DCIM/") ? "/" + cgi : query.queryItemValue("DIR"));
+		const int size  = query.queryItemValue("size").toInt();
+		if (index < 0 || (cgi == "get_resizeimg" && size != 1024 && size != 1600 && size != 1920 && size != 2048)) {
+			status = 404;
+			return QByteArray();
+			}
+		QSize imageSize(2560, 1920); // Original
+		if (cgi == "get_thumbnail")		imageSize = QSize(160, 120);
+		else if (cgi == "get_screennail")	imageSize = QSize(640, 480);
+		else if (cgi == "get_resizeimg")	imageSize = QSize(size, size * 3 / 4);
+		contentType = "image/jpeg";
+		return m_pLiveViewStreamer->createImage(imageSize, (quint32)index);
+		}
+	if (cgi == "get_camprop") {
+		const QString name = query.queryItemValue("propname").trimmed();
+		if (query.queryItemValue("com") != "desc" || (name != "desclist" && !m_Properties.contains(name))) {
+			status = 400;
+			return QByteArray();
+			}
+		contentType = "text/xml";
+		QByteArray body("<?xml version=\"1.0\"?>");
+		if (name == "desclist") {
+			body += "<desclist>";
+			for (auto it = m_Properties.constBegin(); it != m_Properties.constEnd(); ++it)
+				body += describe(it.key());
+			body += "</desclist>";
+			}
+		else {
+			body += describe(name);
+			}
+		return body;
+		}
+	if (cgi == "exec_takemisc") {
+		const QString command = query.queryItemValue("com");
+		if (command == "startliveview") {
+			bool ok = false;
+			const quint16 port = query.queryItemValue("port").toUShort(&ok);
+			if (!ok || port < 1024 || m_CameraMode != "rec") {
+				status = 400;
+				return QByteArray();
+				}
+			m_pLiveViewStreamer->setFrameSize(CLiveViewStreamer::getFrameSize(m_LiveViewQuality));
+			m_pLiveViewStreamer->start(pSocket->peerAddress(), port);
+			return QByteArray();
+			}
+		if (command == "stopliveview") {
+			m_pLiveViewStreamer->stop();
+			return QByteArray();
+			}
+		if (command == "getlastjpg" || command == "getrecview") {
+			contentType = "image/jpeg";
+			return m_pLiveViewStreamer->createImage(CLiveViewStreamer::getFrameSize("1280x0960"), 0);
+			}
+		status = 400;
+		return QByteArray();
+		}
+	status = 404;
+	return QByteArray();
+}
+
+// -----------------------------------------------------------------------
+QByteArray CCameraSimulator::describe(const QString & name) const {
+	const CProperty & property = m_Properties[name];
+	QString desc = QString("<desc><propname>%1</propname><attribute>%2</attribute><value>%3</value>")
+					.arg(name, property.attribute, property.value);
+	if (!property.enumValues.isEmpty())
+		desc += QString("<enum>%1</enum>").arg(property.enumValues);
+	desc += "</desc>";
+	return desc.toUtf8();
+}
+
+// -----------------------------------------------------------------------
+QByteArray CCameraSimulator::getCommandList() const {
+	if (!m_Config.commandListFile.isEmpty()) {
+		QFile file(m_Config.commandListFile);
+		if (file.open(QIODevice::ReadOnly))
+			return file.readAll();
+		qWarning("Simulator: %s not readable", qPrintable(m_Config.commandListFile));
+		}
+	return QByteArray(DEFAULT_COMMAND_LIST);
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: next shutter speed of the enumeration
+void CCameraSimulator::changeProperties() {
+	CProperty & property    = m_Properties["shutspeedvalue"];
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+	const QStringList speeds = property.enumValues.split(' ', Qt::SkipEmptyParts);
+#else
+	const QStringList speeds = property.enumValues.split(' ', QString::SkipEmptyParts);
+#endif
+	const int index          = speeds.indexOf(property.value);
+	property.value           = speeds.value((index + 1) % speeds.size());
+}
+
+// -----------------------------------------------------------------------
+QByteArray CCameraSimulator::createReply(int status, const QByteArray & contentType, const QByteArray & body) {
+	const char * reason = (status == 200) ? "OK" : (status == 400) ? "Bad Request" : (status == 404) ? "Not Found" :
+						  (status == 405) ? "Method Not Allowed" : (status == 503) ? "Service Unavailable" : "Error";
+	QByteArray reply = "HTTP/1.1 " + QByteArray::number(status) + " " + reason + "\r\n";
+	reply += "Content-Type: " + contentType + "\r\n";
+	reply += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+	reply += "Connection: keep-alive\r\n\r\n";
+	return reply + body;
+}
+
+}}} // End namespaces
@@ -0,0 +1,147 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_SIMULATOR_CAMERASIMULATOR_H
+#define DE_BSWALZ_OLYCAMERARC_SIMULATOR_CAMERASIMULATOR_H
+
+/**
+ * OlympusCamera-RemoteControl: simulator of the camera's HTTP interface
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QMap>
+#include <QUrlQuery>
+#include <deque>
+#include <random>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+class CLiveViewStreamer;
+
+// -----------------------------------------------------------------------
+// Class CSimulatorConfig
+// Behaviour of the simulated camera
+// -----------------------------------------------------------------------
+class CSimulatorConfig {
+public:
+	CSimulatorConfig() : httpPort(80), latency(5), acceptDelay(0), jitter(0), errorRate(0.0), propertyChangeInterval(0),
+						 liveViewFps(30), liveViewLossRate(0.0), images(20) {}
+	quint16	httpPort;
+	int		latency;				// ms, added to each reply
+	int		acceptDelay;			// ms, added to the first reply of a connection (slow accept of the camera)
+	int		jitter;					// ms, uniformly distributed 0..jitter added to the latency
+	double	errorRate;				// Percent of the requests answered by "503 Service Unavailable"
+	int		propertyChangeInterval;	// ms, the shutter speed changes periodically, 0: never
+	int		liveViewFps;
+	double	liveViewLossRate;		// Percent of the RTP packets not sent
+	QString	commandListFile;		// Reply of get_commandlist.cgi
+	int		images;					// On the card at start, each shot adds one
+};
+
+// -----------------------------------------------------------------------
+// Class CCameraSimulator
+// Serves the CGIs of docs/get_commandlist-TG-6.xml used by OlyCamera-RC
+// (get_commandlist, switch_cammode, exec_shutter, get_camprop,
+// exec_takemisc, get_imglist, get_thumbnail, get_screennail, get_resizeimg
+// and the images themselves) via HTTP/1.1 with keep-alive and pipelining.
+// Replies of a connection are sent in the order of the requests. The
+// images are synthetic JPEGs of the requested size.
+// -----------------------------------------------------------------------
+class CCameraSimulator : public QObject {
+	Q_OBJECT
+public:
+	CCameraSimulator(const CSimulatorConfig &, QObject * pParent = nullptr);
+	virtual ~CCameraSimulator();
+	bool	start();
+	quint16	getPort() const;
+	/** Statistics of the connection reuse */
+	quint64	getAcceptedConnections() const { return m_AcceptedConnections; }
+	quint64	getRequests() const { return m_Requests; }
+
+signals:
+	/** A request has been received, e.g. "exec_shutter?com=2ndpush" */
+	void	requestReceived(QString);
+
+protected slots:
+	void	newConnection();
+	void	readyRead();
+	void	disconnected();
+	void	sendDueReplies();
+	void	changeProperties();
+
+private:
+	class CReply {
+	public:
+		CReply(qint64 t, const QByteArray & d) : dueTime(t), data(d) {}
+		qint64		dueTime;	// ms, QDateTime::currentMSecsSinceEpoch()
+		QByteArray	data;
+	};
+	class CConnection {
+	public:
+		CConnection() : pTimer(nullptr), requests(0) {}
+		QByteArray			buffer;		// Received, not yet processed
+		std::deque<CReply>	replies;
+		QTimer *			pTimer;
+		quint64				requests;
+	};
+	class CProperty {
+	public:
+		QString		attribute;
+		QString		value;
+		QString		enumValues;	// Space separated
+	};
+
+	void		processRequest(QTcpSocket *, const QByteArray & method, const QByteArray & target);
+	QByteArray	handle(QTcpSocket *, const QString & cgi, const QUrlQuery &, int & status, QByteArray & contentType);
+	QByteArray	describe(const QString & name) const;
+	QByteArray	getCommandList() const;
+	QByteArray	getImageList(const QString & dir) const;
+	/** Index of "/DCIM/100OLYMP/Pnnnnnnn.JPG", -1 if there is no such image */
+	int			getImageIndex(const QString & path) const;
+	static QByteArray createReply(int status, const QByteArray & contentType, const QByteArray & body);
+
+	CSimulatorConfig		m_Config;
+	QTcpServer *			m_pServer;
+	QTimer *				m_pPropertyTimer;
+	CLiveViewStreamer *		m_pLiveViewStreamer;
+	QMap<QTcpSocket*, CConnection>	m_Connections;
+	QMap<QString, CProperty>		m_Properties;
+	QString					m_CameraMode;
+	QString					m_LiveViewQuality;
+	std::mt19937			m_Random;
+	quint64					m_Requests;
+	quint64					m_AcceptedConnections;
+	int						m_Images;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_SIMULATOR_CAMERASIMULATOR_H
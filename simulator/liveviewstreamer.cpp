@@ -0,0 +1,174 @@
+/**
+ * OlympusCamera-RemoteControl: synthetic LiveView stream of the simulator
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "liveviewstreamer.h"
+#include <QtNetwork/QUdpSocket>
+#include <QBuffer>
+#include <QImage>
+#include <QPainter>
+#include <QLinearGradient>
+#include <QTimer>
+#include <QDebug>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLiveViewStreamer
+// -----------------------------------------------------------------------
+CLiveViewStreamer::CLiveViewStreamer(QObject * pParent)
+	: QObject(pParent), m_pSocket(new QUdpSocket(this)), m_pTimer(new QTimer(this)), m_Port(0),
+	  m_FrameSize(640, 480), m_FrameNumber(0), m_SequenceNumber(0), m_Timestamp(0), m_LossRate(0.0),
+	  m_Random(std::random_device()()) {
+	m_pTimer->setTimerType(Qt::PreciseTimer);
+	setFrameRate(30);
+	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(sendFrame()));
+}
+
+// -----------------------------------------------------------------------
+CLiveViewStreamer::~CLiveViewStreamer() {
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewStreamer::setFrameRate(int fps) {
+	m_pTimer->setInterval(1000 / ((fps > 0) ? fps : 1));
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewStreamer::setFrameSize(const QSize & size) {
+	if (size.isEmpty() || size == m_FrameSize)
+		return;
+	m_FrameSize = size;
+	m_Frames.clear(); // Encoded again on demand
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewStreamer::start(const QHostAddress & address, quint16 port) {
+	m_Address = address;
+	m_Port    = port;
+	m_pTimer->start();
+	qDebug("Simulator: LiveView %dx%d to %s:%u", m_FrameSize.width(), m_FrameSize.height(), qPrintable(address.toString()), port);
+}
+
+// -----------------------------------------------------------------------
+void CLiveViewStreamer::stop() {
+	if (m_pTimer->isActive())
+		qDebug("Simulator: LiveView stopped after %u frames", m_FrameNumber);
+	m_pTimer->stop();
+}
+
+// -----------------------------------------------------------------------
+bool CLiveViewStreamer::isRunning() const {
+	return m_pTimer->isActive();
+}
+
+// -----------------------------------------------------------------------
+QSize CLiveViewStreamer::getFrameSize(const QString & liveViewQuality) {
+	const QStringList size = liveViewQuality.split('x');
+	if (size.size() != 2)
+		return QSize();
+	const QSize frameSize(size[0].toInt(), size[1].toInt());
+	return (frameSize.width() >= 320 && frameSize.width() <= 1280 && frameSize.height() >= 240 && frameSize.height() <= 960) ? frameSize : QSize();
+}
+
+// -----------------------------------------------------------------------
+// Gradient with a moving bar and the frame number as binary pattern
+QByteArray CLiveViewStreamer::createImage(const QSize & size, quint32 frameNumber) const {
+	QImage image(size, QImage::Format_RGB32);
+	QPainter painter(&image);
+	QLinearGradient gradient(0, 0, size.width(), size.height());
+	gradient.setColorAt(0.0, QColor(30, 60, 120));
+	gradient.setColorAt(1.0, QColor(200, 160, 60));
+	painter.fillRect(image.rect(), gradient);
+
+	const int barWidth = size.width() / 10;
+	const int position = (int)((frameNumber % FRAME_CYCLE) * (size.width() - barWidth) / FRAME_CYCLE);
+	painter.fillRect(position, 0, barWidth, size.height(), QColor(240, 240, 240));
+
+	const int cell = size.height() / 24;
+	for (int bit = 0; bit < 16; bit++)
+		painter.fillRect(cell + bit * cell, size.height() - 2 * cell, cell - 2, cell,
+						 ((frameNumber >> (15 - bit)) & 1) ? Qt::black : Qt::white);
+	painter.end();
+
+	QByteArray jpeg;
+	QBuffer buffer(&jpeg);
+	buffer.open(QIODevice::WriteOnly);
+	image.save(&buffer, "JPG", 75);
+	return jpeg;
+}
+
+// -----------------------------------------------------------------------
+// Qt slot: sends the next frame in packets of MAX_PAYLOAD_SIZE
+void CLiveViewStreamer::sendFrame() {
+	if (m_Frames.empty()) {
+		for (unsigned int i = 0; i < FRAME_CYCLE; i++)
+			m_Frames.push_back(createImage(m_FrameSize, i));
+		}
+	for (const QByteArray & packet : packetize(m_Frames[m_FrameNumber % FRAME_CYCLE])) {
+		if (m_LossRate > 0.0 && std::uniform_real_distribution<double>(0.0, 100.0)(m_Random) < m_LossRate)
+			continue; // Simulated loss
+		m_pSocket->writeDatagram(packet, m_Address, m_Port);
+		}
+}
+
+// -----------------------------------------------------------------------
+std::vector<QByteArray> CLiveViewStreamer::packetize(const QByteArray & jpeg) {
+	std::vector<QByteArray> packets;
+	m_Timestamp += 90 * m_pTimer->interval(); // 90 kHz clock
+	for (int offset = 0; offset < jpeg.size(); offset += MAX_PAYLOAD_SIZE) {
+		const int size = (jpeg.size() - offset < MAX_PAYLOAD_SIZE) ? jpeg.size() - offset : MAX_PAYLOAD_SIZE;
+		packets.push_back(createPacket(jpeg.constData() + offset, size, offset == 0, offset + size >= jpeg.size()));
+		}
+	m_FrameNumber++;
+	return packets;
+}
+
+// -----------------------------------------------------------------------
+QByteArray CLiveViewStreamer::createPacket(const char * pPayload, int size, bool first, bool last) {
+	const u_int16_t sequenceNumber = m_SequenceNumber++;
+	QByteArray packet;
+	packet.reserve(12 + 8 + size);
+	packet.append((char)(0x80 | (first ? 0x10 : 0x00)));			// V=2, extension in the first packet
+	packet.append((char)((last ? 0x80 : 0x00) | PAYLOAD_TYPE));		// Marker in the last packet
+	packet.append((char)(sequenceNumber >> 8));
+	packet.append((char)(sequenceNumber & 0xFF));
+	for (int shift = 24; shift >= 0; shift -= 8)
+		packet.append((char)((m_Timestamp >> shift) & 0xFF));
+	packet.append("\x4f\x4c\x59\x43", 4);							// SSRC
+	if (first) {	// Extension: profile 0x9060, one word with the frame number
+		packet.append("\x90\x60\x00\x01", 4);
+		for (int shift = 24; shift >= 0; shift -= 8)
+			packet.append((char)((m_FrameNumber >> shift) & 0xFF));
+		}
+	packet.append(pPayload, size);
+	return packet;
+}
+
+}}} // End namespaces
@@ -0,0 +1,96 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_SIMULATOR_LIVEVIEWSTREAMER_H
+#define DE_BSWALZ_OLYCAMERARC_SIMULATOR_LIVEVIEWSTREAMER_H
+
+/**
+ * OlympusCamera-RemoteControl: synthetic LiveView stream of the simulator
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QSize>
+#include <random>
+#include <vector>
+#include <sys/types.h>
+
+class QTimer;
+class QUdpSocket;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CLiveViewStreamer
+// Sends synthetic JPEG images as RTP packets like the camera: the first
+// packet of a frame carries an extension header, the last one the marker.
+// FRAME_CYCLE different images are encoded once per size and then repeated.
+// -----------------------------------------------------------------------
+class CLiveViewStreamer : public QObject {
+	Q_OBJECT
+public:
+	static const int          MAX_PAYLOAD_SIZE = 1400;	// Bytes per RTP packet
+	static const unsigned int FRAME_CYCLE      = 30;
+	static const u_int8_t     PAYLOAD_TYPE     = 96;
+
+	CLiveViewStreamer(QObject * pParent = nullptr);
+	virtual ~CLiveViewStreamer();
+	void	setFrameRate(int fps);
+	void	setLossRate(double percent) { m_LossRate = percent; }
+	void	setFrameSize(const QSize &);
+	void	start(const QHostAddress &, quint16 port);
+	void	stop();
+	bool	isRunning() const;
+
+	/** JPEG of the given size, the frame number moves the pattern */
+	QByteArray	createImage(const QSize &, quint32 frameNumber) const;
+	/** RTP packets of the next frame, advances sequence number and timestamp */
+	std::vector<QByteArray> packetize(const QByteArray & jpeg);
+	/** Pixel size of "lvqty", empty if unknown */
+	static QSize getFrameSize(const QString & liveViewQuality);
+
+protected slots:
+	void	sendFrame();
+
+private:
+	QByteArray	createPacket(const char * pPayload, int size, bool first, bool last);
+
+	QUdpSocket *		m_pSocket;
+	QTimer *			m_pTimer;
+	QHostAddress		m_Address;
+	quint16				m_Port;
+	QSize				m_FrameSize;
+	std::vector<QByteArray> m_Frames;	// Encoded images of m_FrameSize
+	quint32				m_FrameNumber;
+	u_int16_t			m_SequenceNumber;
+	u_int32_t			m_Timestamp;
+	double				m_LossRate;
+	std::mt19937		m_Random;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_SIMULATOR_LIVEVIEWSTREAMER_H
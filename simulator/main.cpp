@@ -0,0 +1,73 @@
+/**
+ * OlympusCamera-RemoteControl: headless camera simulator
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "camerasimulator.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("OlyCamera-Simulator");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Simulates the HTTP and LiveView interface of an Olympus camera, e.g. on loopback:\n"
+									 "OLYCAMERARC_CAMERA_ADDRESS=127.0.0.1:8080 OlyCamera-RC");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "port",            "HTTP port (default 80).",                                  "port",    "80" },
+		{ "latency",         "Latency of each reply in ms (default 5).",                 "ms",      "5" },
+		{ "jitter",          "Additional random latency 0..ms (default 0).",             "ms",      "0" },
+		{ "accept-delay",    "Additional latency of the first reply of a connection in ms (default 0).", "ms", "0" },
+		{ "error-rate",      "Percent of requests failing with 503 (default 0).",        "percent", "0" },
+		{ "property-change", "Interval of shutter speed changes in ms (default 0: off).", "ms",      "0" },
+		{ "fps",             "LiveView frames per second (default 30).",                 "fps",     "30" },
+		{ "loss-rate",       "Percent of RTP packets dropped (default 0).",              "percent", "0" },
+		{ "images",          "Images on the card (default 20), each shot adds one.",     "count",   "20" },
+		{ "commandlist",     "File served by get_commandlist.cgi, e.g. docs/get_commandlist-TG-6.xml.", "file" } });
+	parser.process(app);
+
+	de::bswalz::olycamerarc::CSimulatorConfig config;
+	config.httpPort               = parser.value("port").toUShort();
+	config.latency                = parser.value("latency").toInt();
+	config.jitter                 = parser.value("jitter").toInt();
+	config.acceptDelay            = parser.value("accept-delay").toInt();
+	config.errorRate              = parser.value("error-rate").toDouble();
+	config.propertyChangeInterval = parser.value("property-change").toInt();
+	config.liveViewFps            = parser.value("fps").toInt();
+	config.liveViewLossRate       = parser.value("loss-rate").toDouble();
+	config.commandListFile        = parser.value("commandlist");
+	config.images                 = parser.value("images").toInt();
+
+	de::bswalz::olycamerarc::CCameraSimulator simulator(config);
+	if (!simulator.start())
+		return 1;
+	return app.exec();
+}
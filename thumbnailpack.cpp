@@ -0,0 +1,197 @@
+/**
+ * OlympusCamera-RemoteControl: memory-mapped thumbnail cache
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "thumbnailpack.h"
+#include <QDir>
+#include <string.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+const char     PACK_MAGIC[]  = "OLYTPACK";
+const char     INDEX_MAGIC[] = "OLYTPIDX";
+const uint32_t PACK_VERSION  = 1;
+}
+
+// -----------------------------------------------------------------------
+// Class CThumbnailPack
+// -----------------------------------------------------------------------
+CThumbnailPack::CThumbnailPack() : m_PackSize(0), m_IndexSize(0) {
+	static_assert(sizeof(CIndexEntry) == 40, "Layout of the index file");
+	static_assert(sizeof(CFileHeader) == 16, "Layout of the file header");
+}
+
+// -----------------------------------------------------------------------
+CThumbnailPack::~CThumbnailPack() {
+	close();
+}
+
+// -----------------------------------------------------------------------
+bool CThumbnailPack::open(const QString & dir) {
+	close();
+	QDir().mkpath(dir);
+	m_PackFile.setFileName(dir + "/thumbnails.pack");
+	m_IndexFile.setFileName(dir + "/thumbnails.idx");
+	if (!m_PackFile.open(QIODevice::ReadWrite) || !m_IndexFile.open(QIODevice::ReadWrite) ||
+		!checkHeader(m_PackFile, PACK_MAGIC, 0) || !checkHeader(m_IndexFile, INDEX_MAGIC, sizeof(CIndexEntry))) {
+		qDebug("Thumbnail pack: %s can't be opened", qPrintable(dir));
+		close();
+		return false;
+		}
+	m_PackSize = m_PackFile.size();
+	if (!readIndex()) {
+		close();
+		return false;
+		}
+	qDebug("Thumbnail pack: %d entries, %lld bytes", getCount(), (long long)m_PackSize);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Writes the header into an empty file, an incompatible file is reset
+bool CThumbnailPack::checkHeader(QFile & file, const char * magic, uint32_t entrySize) {
+	CFileHeader header;
+	if (file.size() >= (qint64)sizeof(header) && file.read((char*)&header, sizeof(header)) == sizeof(header) &&
+		memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == PACK_VERSION && header.entrySize == entrySize)
+		return true;
+	memcpy(header.magic, magic, sizeof(header.magic));
+	header.version   = PACK_VERSION;
+	header.entrySize = entrySize;
+	return file.resize(0) && file.seek(0) && file.write((const char*)&header, sizeof(header)) == sizeof(header) && file.flush();
+}
+
+// -----------------------------------------------------------------------
+// Maps the index once, entries beyond the end of the pack file are dropped
+bool CThumbnailPack::readIndex() {
+	const qint64 count = (m_IndexFile.size() - (qint64)sizeof(CFileHeader)) / (qint64)sizeof(CIndexEntry);
+	const qint64 size  = (qint64)sizeof(CFileHeader) + count * (qint64)sizeof(CIndexEntry);
+	qint64 validCount  = 0;
+	if (count > 0) {
+		const uchar * pIndex = m_IndexFile.map(0, size);
+		if (pIndex == nullptr)
+			return false;
+		const CIndexEntry * pEntries = (const CIndexEntry*)(pIndex + sizeof(CFileHeader));
+		for (qint64 i = 0; i < count; i++) {
+			const CIndexEntry & entry = pEntries[i];
+			if ((qint64)(entry.offset + entry.length) > m_PackSize)
+				break;
+			const QByteArray key((const char*)entry.key, KEY_SIZE);
+			m_Entries[getMapKey(key, (EKind)entry.kind)] = CLocation((qint64)entry.offset, (qint64)entry.length);
+			validCount++;
+			}
+		m_IndexFile.unmap((uchar*)pIndex);
+		}
+	// Incomplete entries are overwritten by the next append()
+	m_IndexSize = (qint64)sizeof(CFileHeader) + validCount * (qint64)sizeof(CIndexEntry);
+	return m_IndexSize == m_IndexFile.size() || m_IndexFile.resize(m_IndexSize);
+}
+
+// -----------------------------------------------------------------------
+void CThumbnailPack::close() {
+	for (const CRegion & region : m_Regions)
+		m_PackFile.unmap(region.pData);
+	m_Regions.clear();
+	m_Entries.clear();
+	m_PackFile.close();
+	m_IndexFile.close();
+	m_PackSize  = 0;
+	m_IndexSize = 0;
+}
+
+// -----------------------------------------------------------------------
+QByteArray CThumbnailPack::getMapKey(const QByteArray & key, EKind kind) {
+	QByteArray mapKey(key);
+	mapKey.append((char)kind);
+	return mapKey;
+}
+
+// -----------------------------------------------------------------------
+bool CThumbnailPack::contains(const QByteArray & key, EKind kind) const {
+	return m_Entries.find(getMapKey(key, kind)) != m_Entries.end();
+}
+
+// -----------------------------------------------------------------------
+QByteArray CThumbnailPack::get(const QByteArray & key, EKind kind) {
+	auto it = m_Entries.find(getMapKey(key, kind));
+	if (it == m_Entries.end())
+		return QByteArray();
+	const uchar * pData = map(it->second);
+	return (pData != nullptr) ? QByteArray::fromRawData((const char*)pData, (int)it->second.length) : QByteArray();
+}
+
+// -----------------------------------------------------------------------
+// Address of the data, the part of the pack file not yet mapped is mapped
+const uchar * CThumbnailPack::map(const CLocation & location) {
+	for (const CRegion & region : m_Regions)
+		if (location.offset >= region.offset && location.offset + location.length <= region.offset + region.size)
+			return region.pData + (location.offset - region.offset);
+
+	const qint64 mappedEnd = m_Regions.empty() ? 0 : m_Regions.back().offset + m_Regions.back().size;
+	if (location.offset < mappedEnd || location.offset + location.length > m_PackSize)
+		return nullptr;
+	uchar * pData = m_PackFile.map(mappedEnd, m_PackSize - mappedEnd);
+	if (pData == nullptr)
+		return nullptr;
+	m_Regions.push_back(CRegion(mappedEnd, m_PackSize - mappedEnd, pData));
+	return pData + (location.offset - mappedEnd);
+}
+
+// -----------------------------------------------------------------------
+bool CThumbnailPack::append(const QByteArray & key, EKind kind, const QByteArray & data) {
+	if (!isOpen() || key.size() != KEY_SIZE || data.isEmpty())
+		return false;
+	if (contains(key, kind))
+		return true;
+
+	CIndexEntry entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.offset = (uint64_t)m_PackSize;
+	entry.length = (uint32_t)data.size();
+	entry.kind   = (uint8_t)kind;
+	memcpy(entry.key, key.constData(), KEY_SIZE);
+
+	// Data first, the index entry makes it valid
+	if (!m_PackFile.seek(m_PackSize) || m_PackFile.write(data) != data.size() || !m_PackFile.flush())
+		return false;
+	if (!m_IndexFile.seek(m_IndexSize) || m_IndexFile.write((const char*)&entry, sizeof(entry)) != sizeof(entry) || !m_IndexFile.flush()) {
+		// A partial entry would shift all following ones: it is cut off, otherwise the cache is disabled
+		if (!m_IndexFile.resize(m_IndexSize)) {
+			qDebug("Thumbnail pack: index can't be repaired, cache disabled");
+			close();
+			}
+		return false;
+		}
+	m_IndexSize += sizeof(entry);
+	m_PackSize  += data.size();
+	m_Entries[getMapKey(key, kind)] = CLocation((qint64)entry.offset, (qint64)entry.length);
+	return true;
+}
+
+}}} // End namespaces
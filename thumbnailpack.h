@@ -0,0 +1,118 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_THUMBNAILPACK_H
+#define DE_BSWALZ_OLYCAMERARC_THUMBNAILPACK_H
+
+/**
+ * OlympusCamera-RemoteControl: memory-mapped thumbnail cache
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CThumbnailPack
+// Cache of thumbnails and screennails in one append-only pack file with
+// an index of fixed-size entries (host byte order, little endian on all
+// targets). The index is read once on open(), the pack file is memory
+// mapped: a lookup needs neither open() nor read(). The pack file is
+// mapped in regions, a region grown by append() is mapped additionally,
+// so the data returned by get() stays valid until close().
+// An entry is appended to the index after its data, a truncated tail
+// (e.g. after a crash) is ignored on the next open().
+// -----------------------------------------------------------------------
+class CThumbnailPack {
+public:
+	enum EKind { EK_Thumbnail = 0, EK_Screennail = 1 };
+	static const int KEY_SIZE = 20;	// SHA-1
+
+	CThumbnailPack();
+	~CThumbnailPack();
+
+	/** Opens resp. creates "thumbnails.pack" and "thumbnails.idx" in dir */
+	bool		open(const QString & dir);
+	void		close();
+	bool		isOpen() const { return m_PackFile.isOpen(); }
+	int			getCount() const { return (int)m_Entries.size(); }
+	bool		contains(const QByteArray & key, EKind) const;
+	/** Mapped data without copy, valid until close(), empty if not available */
+	QByteArray	get(const QByteArray & key, EKind);
+	/** Appends the data (e.g. a JPEG) of a key */
+	bool		append(const QByteArray & key, EKind, const QByteArray & data);
+
+private:
+	// Entry of the index file, 40 bytes
+	struct CIndexEntry {
+		uint64_t	offset;		// In the pack file
+		uint32_t	length;
+		uint8_t		kind;		// EKind
+		uint8_t		reserved[3];
+		uint8_t		key[KEY_SIZE];
+		uint32_t	reserved2;
+	};
+	// Header of both files, 16 bytes
+	struct CFileHeader {
+		char		magic[8];
+		uint32_t	version;
+		uint32_t	entrySize;
+	};
+	class CLocation {
+	public:
+		CLocation(qint64 o = 0, qint64 l = 0) : offset(o), length(l) {}
+		qint64	offset;
+		qint64	length;
+	};
+	class CRegion {
+	public:
+		CRegion(qint64 o, qint64 s, uchar * p) : offset(o), size(s), pData(p) {}
+		qint64	offset;
+		qint64	size;
+		uchar *	pData;
+	};
+
+	static QByteArray	getMapKey(const QByteArray & key, EKind);
+	static bool			checkHeader(QFile &, const char * magic, uint32_t entrySize);
+	bool				readIndex();
+	const uchar *		map(const CLocation &);
+
+	QFile					m_PackFile;
+	QFile					m_IndexFile;
+	qint64					m_PackSize;
+	qint64					m_IndexSize;		// Of the valid entries, the next one is written there
+	std::map<QByteArray, CLocation>	m_Entries;	// Key: SHA-1 + EKind
+	std::vector<CRegion>	m_Regions;			// Mapped regions of the pack file
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_THUMBNAILPACK_H
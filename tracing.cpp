@@ -0,0 +1,167 @@
+/**
+ * OlympusCamera-RemoteControl: tracing of the hot paths
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "tracing.h"
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CTraceBuffer
+// -----------------------------------------------------------------------
+std::vector<CTraceEvent> CTraceBuffer::getEvents() const {
+	const uint64_t end   = m_WriteIndex.load(std::memory_order_acquire);
+	const uint64_t begin = (end > CAPACITY) ? end - CAPACITY : 0;
+	std::vector<CTraceEvent> events;
+	events.reserve(end - begin);
+	for (uint64_t i = begin; i < end; i++)
+		events.push_back(m_Events[i & (CAPACITY - 1)]);
+	return events;
+}
+
+// -----------------------------------------------------------------------
+// Class CTracer
+// -----------------------------------------------------------------------
+std::atomic<bool>	CTracer::m_Enabled(false);
+std::mutex			CTracer::m_BuffersMutex;
+std::vector<std::unique_ptr<CTraceBuffer>> CTracer::m_Buffers;
+
+// -----------------------------------------------------------------------
+// The buffers live until the end of the process, so events of finished
+// threads can still be exported
+CTraceBuffer * CTracer::getThreadBuffer() {
+	thread_local CTraceBuffer * pBuffer = nullptr;
+	if (pBuffer == nullptr) {
+		std::lock_guard<std::mutex> lock(m_BuffersMutex);
+		m_Buffers.emplace_back(new CTraceBuffer(m_Buffers.size() + 1));
+		pBuffer = m_Buffers.back().get();
+		}
+	return pBuffer;
+}
+
+// -----------------------------------------------------------------------
+void CTracer::add(const char * name, int64_t timestamp, int64_t duration, uint64_t id, char phase) {
+	CTraceEvent event;
+	event.name      = name;
+	event.timestamp = timestamp;
+	event.duration  = duration;
+	event.id        = id;
+	event.phase     = phase;
+	getThreadBuffer()->add(event);
+}
+
+// -----------------------------------------------------------------------
+void CTracer::complete(const char * name, int64_t start, int64_t end) {
+	if (isEnabled()) add(name, start, end - start, 0, 'X');
+}
+
+// -----------------------------------------------------------------------
+void CTracer::instant(const char * name) {
+	if (isEnabled()) add(name, CLatencyClock::now(), 0, 0, 'i');
+}
+
+// -----------------------------------------------------------------------
+void CTracer::asyncBegin(const char * name, uint64_t id) {
+	if (isEnabled()) add(name, CLatencyClock::now(), 0, id, 'b');
+}
+
+// -----------------------------------------------------------------------
+void CTracer::asyncEnd(const char * name, uint64_t id) {
+	if (isEnabled()) add(name, CLatencyClock::now(), 0, id, 'e');
+}
+
+// -----------------------------------------------------------------------
+void CTracer::setThreadName(const char * name) {
+	CTraceBuffer * pBuffer = getThreadBuffer();
+	std::lock_guard<std::mutex> lock(m_BuffersMutex);
+	pBuffer->setThreadName(name);
+}
+
+// -----------------------------------------------------------------------
+void CTracer::clear() {
+	std::lock_guard<std::mutex> lock(m_BuffersMutex);
+	for (auto & upBuffer : m_Buffers)
+		upBuffer->clear();
+}
+
+// -----------------------------------------------------------------------
+// Escapes a name for JSON
+static std::string toJsonString(const char * text) {
+	std::string result("\"");
+	for (const char * p = text; p != nullptr && *p != 0; p++) {
+		if (*p == '"' || *p == '\\')	{ result += '\\'; result += *p; }
+		else if ((unsigned char)*p >= 0x20)	result += *p;
+		}
+	return result + "\"";
+}
+
+// -----------------------------------------------------------------------
+bool CTracer::exportChromeTrace(const std::string & fileName) {
+	std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+	const long pid = (long)::getpid();
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	std::lock_guard<std::mutex> lock(m_BuffersMutex);
+	for (const auto & upBuffer : m_Buffers) {
+		const uint64_t tid = upBuffer->getThreadId();
+		if (!upBuffer->getThreadName().empty()) {
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+				 << ",\"args\":{\"name\":" << toJsonString(upBuffer->getThreadName().c_str()) << "}}";
+			first = false;
+			}
+		char number[64];
+		for (const CTraceEvent & event : upBuffer->getEvents()) {
+			snprintf(number, sizeof(number), "%.3f", event.timestamp / 1e3); // us
+			file << (first ? "" : ",\n") << "{\"name\":" << toJsonString(event.name) << ",\"cat\":\"olycamerarc\",\"ph\":\""
+				 << event.phase << "\",\"ts\":" << number << ",\"pid\":" << pid << ",\"tid\":" << tid;
+			if (event.phase == 'X') {
+				snprintf(number, sizeof(number), "%.3f", event.duration / 1e3);
+				file << ",\"dur\":" << number;
+				}
+			else if (event.phase == 'i') {
+				file << ",\"s\":\"t\"";
+				}
+			else {
+				snprintf(number, sizeof(number), "0x%llx", (unsigned long long)event.id);
+				file << ",\"id\":\"" << number << "\"";
+				}
+			file << "}";
+			first = false;
+			}
+		}
+	file << "\n]}\n";
+	return file.good();
+}
+
+}}} // End namespaces
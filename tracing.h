@@ -0,0 +1,151 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_TRACING_H
+#define DE_BSWALZ_OLYCAMERARC_TRACING_H
+
+/**
+ * OlympusCamera-RemoteControl: tracing of the hot paths
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+#include "latencystatistics.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------
+// Trace macros, without effect if OLYCAMERARC_NO_TRACING is defined. The
+// names have to be string literals (or otherwise static strings).
+// -----------------------------------------------------------------------
+#if !defined(OLYCAMERARC_NO_TRACING)
+#define OLYCAMERARC_TRACE_CONCAT2(a, b)		a##b
+#define OLYCAMERARC_TRACE_CONCAT(a, b)		OLYCAMERARC_TRACE_CONCAT2(a, b)
+#define OLYCAMERARC_TRACE_SCOPE(name)		de::bswalz::olycamerarc::CTraceScope OLYCAMERARC_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define OLYCAMERARC_TRACE_INSTANT(name)		de::bswalz::olycamerarc::CTracer::instant(name)
+#define OLYCAMERARC_TRACE_ASYNC_BEGIN(name, id)	de::bswalz::olycamerarc::CTracer::asyncBegin(name, (uint64_t)(id))
+#define OLYCAMERARC_TRACE_ASYNC_END(name, id)	de::bswalz::olycamerarc::CTracer::asyncEnd(name, (uint64_t)(id))
+#define OLYCAMERARC_TRACE_THREAD_NAME(name)	de::bswalz::olycamerarc::CTracer::setThreadName(name)
+#else
+#define OLYCAMERARC_TRACE_SCOPE(name)
+#define OLYCAMERARC_TRACE_INSTANT(name)
+#define OLYCAMERARC_TRACE_ASYNC_BEGIN(name, id)
+#define OLYCAMERARC_TRACE_ASYNC_END(name, id)
+#define OLYCAMERARC_TRACE_THREAD_NAME(name)
+#endif
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CTraceEvent
+// -----------------------------------------------------------------------
+class CTraceEvent {
+public:
+	const char *	name;
+	int64_t			timestamp;	// CLatencyClock
+	int64_t			duration;	// ns, complete events only
+	uint64_t		id;			// Async events only
+	char			phase;		// Chrome trace phase: 'X' complete, 'i' instant, 'b'/'e' async
+};
+
+// -----------------------------------------------------------------------
+// Class CTraceBuffer
+// Ring buffer of one thread. Written by its thread only (lock-free), the
+// oldest events are overwritten.
+// -----------------------------------------------------------------------
+class CTraceBuffer {
+public:
+	static const unsigned int CAPACITY = 16384;		// Events, power of two
+
+	CTraceBuffer(uint64_t threadId) : m_ThreadId(threadId), m_Events(CAPACITY), m_WriteIndex(0) {}
+	void	add(const CTraceEvent & event) {
+		const uint64_t index = m_WriteIndex.load(std::memory_order_relaxed);
+		m_Events[index & (CAPACITY - 1)] = event;
+		m_WriteIndex.store(index + 1, std::memory_order_release);
+		}
+	/** Copy of the events, oldest first */
+	std::vector<CTraceEvent> getEvents() const;
+	void	clear() { m_WriteIndex.store(0, std::memory_order_release); }
+	uint64_t getThreadId() const { return m_ThreadId; }
+	void	setThreadName(const std::string & name) { m_ThreadName = name; }
+	const std::string & getThreadName() const { return m_ThreadName; }
+private:
+	uint64_t					m_ThreadId;
+	std::string					m_ThreadName;
+	std::vector<CTraceEvent>	m_Events;
+	std::atomic<uint64_t>		m_WriteIndex;
+};
+
+// -----------------------------------------------------------------------
+// Class CTracer
+// Collects the trace events of all threads. Disabled by default, then an
+// event costs one relaxed atomic load.
+// -----------------------------------------------------------------------
+class CTracer {
+public:
+	static bool	isEnabled() { return m_Enabled.load(std::memory_order_relaxed); }
+	static void	setEnabled(bool enabled) { m_Enabled.store(enabled, std::memory_order_relaxed); }
+
+	static void	complete(const char * name, int64_t start, int64_t end);
+	static void	instant(const char * name);
+	static void	asyncBegin(const char * name, uint64_t id);
+	static void	asyncEnd(const char * name, uint64_t id);
+	/** Name of the calling thread in the trace */
+	static void	setThreadName(const char * name);
+
+	/** Writes the events of all threads in the Chrome trace format (JSON),
+	 *  to be opened by chrome://tracing or https://ui.perfetto.dev */
+	static bool	exportChromeTrace(const std::string & fileName);
+	static void	clear();
+private:
+	static CTraceBuffer * getThreadBuffer();
+	static void	add(const char * name, int64_t timestamp, int64_t duration, uint64_t id, char phase);
+
+	static std::atomic<bool>	m_Enabled;
+	static std::mutex			m_BuffersMutex;		// Registration of threads and export only
+	static std::vector<std::unique_ptr<CTraceBuffer>> m_Buffers;
+};
+
+// -----------------------------------------------------------------------
+// Class CTraceScope
+// Complete event of the lifetime of the object
+// -----------------------------------------------------------------------
+class CTraceScope {
+public:
+	CTraceScope(const char * name) : m_Name(name), m_Start(CTracer::isEnabled() ? CLatencyClock::now() : 0) {}
+	~CTraceScope() {
+		if (m_Start != 0)
+			CTracer::complete(m_Name, m_Start, CLatencyClock::now());
+		}
+private:
+	const char *	m_Name;
+	int64_t			m_Start;
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_TRACING_H
@@ -0,0 +1,155 @@
+/**
+ * OlympusCamera-RemoteControl: precisely timed trigger commands
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "triggerscheduler.h"
+#include "tracing.h"
+#include <QTcpSocket>
+#include <chrono>
+#include <thread>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CTriggerScheduler
+// -----------------------------------------------------------------------
+CTriggerScheduler::CTriggerScheduler() : QObject(), m_pSocket(nullptr), m_Port(80) {
+	// Intentionally left blank
+}
+
+// -----------------------------------------------------------------------
+CTriggerScheduler::~CTriggerScheduler() {
+	delete m_pSocket;
+}
+
+// -----------------------------------------------------------------------
+void CTriggerScheduler::setCameraAddress(const QString & address) {
+	const int colon = address.indexOf(':');
+	m_Host = (colon >= 0) ? address.left(colon) : address;
+	m_Port = (colon >= 0) ? (quint16)address.mid(colon + 1).toUInt() : 80;
+	stop(); // Reconnects to the new address
+}
+
+// -----------------------------------------------------------------------
+void CTriggerScheduler::warmUp() {
+	OLYCAMERARC_TRACE_THREAD_NAME("Trigger");
+	ensureConnected();
+}
+
+// -----------------------------------------------------------------------
+void CTriggerScheduler::stop() {
+	if (m_pSocket != nullptr)
+		m_pSocket->abort();
+}
+
+// -----------------------------------------------------------------------
+// The camera closes idle connections, the check is repeated before each trigger
+bool CTriggerScheduler::ensureConnected() {
+	if (m_pSocket == nullptr) {
+		m_pSocket = new QTcpSocket();
+		m_pSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		}
+	if (m_pSocket->state() == QAbstractSocket::ConnectedState)
+		return true;
+	OLYCAMERARC_TRACE_SCOPE("Trigger connect");
+	m_pSocket->abort();
+	m_pSocket->connectToHost(m_Host, m_Port);
+	if (!m_pSocket->waitForConnected(CONNECT_TIMEOUT)) {
+		qDebug("Trigger: connection to %s:%u failed", qPrintable(m_Host), m_Port);
+		return false;
+		}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+void CTriggerScheduler::trigger(qint64 targetTime, const QByteArray & path) {
+	if (!ensureConnected()) {
+		emit triggerFinished(targetTime, 0, false);
+		return;
+		}
+	const QByteArray request = "GET " + path + " HTTP/1.1\r\nHost: " + m_Host.toLatin1() +
+							   "\r\nUser-Agent: OlympusCameraKit\r\nConnection: keep-alive\r\n\r\n";
+
+	// Sleeps until shortly before the target time, then spins
+	const int64_t sleepUntil = targetTime - SPIN_TIME;
+	if (sleepUntil > CLatencyClock::now())
+		std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(sleepUntil))));
+	while (CLatencyClock::now() < targetTime)
+		; // Intentionally left blank
+
+	m_pSocket->write(request);
+	m_pSocket->flush();
+	const int64_t sendTime = CLatencyClock::now();
+	OLYCAMERARC_TRACE_INSTANT("Trigger sent");
+
+	const int64_t deviation = sendTime - targetTime;
+	m_Jitter.add(deviation >= 0 ? deviation : -deviation);
+	qDebug("Trigger sent %+.3f ms from target (p50 %.3f ms, p95 %.3f ms, max %.3f ms)", deviation / 1e6,
+		   m_Jitter.getPercentile(50.0) / 1e6, m_Jitter.getPercentile(95.0) / 1e6, m_Jitter.getMax() / 1e6);
+
+	emit triggerFinished(targetTime, sendTime, readReply());
+}
+
+// -----------------------------------------------------------------------
+// Reads status line, header and body (Content-Length) of the reply
+bool CTriggerScheduler::readReply() {
+	QByteArray header;
+	while (!header.endsWith("\r\n\r\n")) {
+		if (!m_pSocket->canReadLine() && !m_pSocket->waitForReadyRead(REPLY_TIMEOUT)) {
+			m_pSocket->abort();
+			return false;
+			}
+		while (m_pSocket->canReadLine() && !header.endsWith("\r\n\r\n"))
+			header += m_pSocket->readLine();
+		}
+	const int status = header.mid(header.indexOf(' ') + 1, 3).toInt();
+
+	qint64 contentLength = 0;
+	bool   close         = false;
+	for (const QByteArray & line : header.split('\n')) {
+		const QByteArray field = line.trimmed().toLower();
+		if (field.startsWith("content-length:"))
+			contentLength = field.mid(15).trimmed().toLongLong();
+		else if (field.startsWith("connection:") && field.contains("close"))
+			close = true;
+		}
+	while (contentLength > 0) {
+		if (m_pSocket->bytesAvailable() == 0 && !m_pSocket->waitForReadyRead(REPLY_TIMEOUT)) {
+			m_pSocket->abort();
+			return false;
+			}
+		contentLength -= m_pSocket->read(contentLength).size();
+		}
+	if (close)
+		m_pSocket->abort(); // Reconnected by the next trigger
+	return status == 200;
+}
+
+}}} // End namespaces
@@ -0,0 +1,87 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_TRIGGERSCHEDULER_H
+#define DE_BSWALZ_OLYCAMERARC_TRIGGERSCHEDULER_H
+
+/**
+ * OlympusCamera-RemoteControl: precisely timed trigger commands
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "latencystatistics.h"
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+class QTcpSocket;
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CTriggerScheduler
+// Sends trigger commands at a given time of CLatencyClock. Lives in its
+// own thread with a keep-alive connection to the camera, which is opened
+// in advance (warmUp(), trigger()). trigger() blocks the thread until the
+// target time: sleeping up to SPIN_TIME before it, then spinning. The
+// reply is read synchronously, its body is discarded.
+// -----------------------------------------------------------------------
+class CTriggerScheduler : public QObject {
+	Q_OBJECT
+public:
+	static const int     CONNECT_TIMEOUT = 1000;		// ms
+	static const int     REPLY_TIMEOUT   = 3000;		// ms
+	static const int64_t SPIN_TIME       = 500000LL;	// ns
+
+	CTriggerScheduler();
+	virtual ~CTriggerScheduler();
+
+public slots:
+	/** Address of the camera's HTTP server, "host[:port]" */
+	void	setCameraAddress(const QString &);
+	/** Opens the connection to the camera if it isn't open */
+	void	warmUp();
+	/** Closes the connection */
+	void	stop();
+	/** Sends "GET path" at targetTime (CLatencyClock, ns) and waits for the reply */
+	void	trigger(qint64 targetTime, const QByteArray & path);
+
+signals:
+	/** Result of trigger(), sendTime: CLatencyClock after writing the request */
+	void	triggerFinished(qint64 targetTime, qint64 sendTime, bool ok);
+
+private:
+	bool	ensureConnected();
+	bool	readReply();
+
+	QTcpSocket *		m_pSocket;
+	QString				m_Host;
+	quint16				m_Port;
+	CLatencyHistogram	m_Jitter;		// |send time - target time|
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_TRIGGERSCHEDULER_H
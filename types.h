@@ -36,11 +36,12 @@ namespace de { namespace bswalz { namespace olycamerarc {
 enum EOlyCommands   { EOCNoCommand, EOCSetRecMode, EOCSetShutterMode, EOC1stPush, EOC1stRelease, EOC2ndPush, EOC2ndRelease, EOC1st2ndPush, EOC2nd1stRelease,
                       EOCRequestShutterSpeed, EOCRequestFocalValue, EOCRequestEVValue, EOCRequestISOValue, EOCRequestCameraDriveMode,
                       EOCStartLiveView, EOCStopLiveView, EOCGetLastImage, EOCGetRecView, EOCStoreImage,
-                      EOCRequestCommandList };
-enum EState         { Init = 0, FocusRequest = 1, Focussed = 2, FocusRelease = 3, TriggerRequest = 4, Triggered = 5, TriggerRelease = 6 };
+                      EOCRequestCommandList, EOCRequestDescList, EOCSetPlayMode };
+enum EState         { Init = 0, FocusRequest = 1, Focussed = 2, FocusRelease = 3, TriggerRequest = 4, Triggered = 5, TriggerRelease = 6, Sequence = 7 };
 enum EWifiStatus    { EWifiNotConnected = 0, EWifiConnected = 1, EWifiOlyCameraConnected = 2 };
-enum ECameraMode	{ ECM_Undefined, ECM_RecMode, ECM_ShutterMode };
+enum ECameraMode	{ ECM_Undefined, ECM_RecMode, ECM_ShutterMode, ECM_PlayMode };
 enum EExposeMode    { EEM_Undefined = 0, EEM_Normal = 1,  EEM_Continuous = 2, EEM_Self = 3, EEM_Composite = 4 };
+enum ELiveViewQuality { ELVQ_0320x0240 = 0, ELVQ_0640x0480 = 1, ELVQ_0800x0600 = 2, ELVQ_1024x0768 = 3, ELVQ_1280x0960 = 4 };
 
 }}} // End namespaces
 
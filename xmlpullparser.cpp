@@ -0,0 +1,219 @@
+/**
+ * OlympusCamera-RemoteControl: parsing of the XML replies of the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include "xmlpullparser.h"
+#include <string.h>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+namespace {
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+}
+
+// -----------------------------------------------------------------------
+// Class CXmlText
+// -----------------------------------------------------------------------
+bool CXmlText::equals(const char * text) const {
+	return strncmp(data, text, size) == 0 && text[size] == '\0';
+}
+
+// -----------------------------------------------------------------------
+bool CXmlText::equals(const CXmlText & text) const {
+	return size == text.size && memcmp(data, text.data, size) == 0;
+}
+
+// -----------------------------------------------------------------------
+bool CXmlText::startsWith(const char * text) const {
+	const size_t length = strlen(text);
+	return length <= size && memcmp(data, text, length) == 0;
+}
+
+// -----------------------------------------------------------------------
+CXmlText CXmlText::trimmed() const {
+	const char * pBegin = data;
+	const char * pEnd   = data + size;
+	while (pBegin < pEnd && isSpace(*pBegin))   pBegin++;
+	while (pEnd > pBegin && isSpace(pEnd[-1]))  pEnd--;
+	return CXmlText(pBegin, pEnd - pBegin);
+}
+
+// -----------------------------------------------------------------------
+// Class CXmlPullParser
+// -----------------------------------------------------------------------
+CXmlPullParser::CXmlPullParser(const char * pData, size_t size)
+	: m_Pos(pData), m_End(pData + size), m_Event(EXE_EndDocument), m_Depth(0), m_PendingEnd(false) {
+}
+
+// -----------------------------------------------------------------------
+// First occurrence of text at or after the current position, nullptr if none
+const char * CXmlPullParser::find(const char * text) const {
+	const size_t length = strlen(text);
+	for (const char * p = m_Pos; p + length <= m_End; p++) {
+		p = (const char*)memchr(p, text[0], m_End - p);
+		if (p == nullptr || p + length > m_End)
+			return nullptr;
+		if (memcmp(p, text, length) == 0)
+			return p;
+		}
+	return nullptr;
+}
+
+// -----------------------------------------------------------------------
+CXmlPullParser::EEvent CXmlPullParser::next() {
+	if (m_PendingEnd) {
+		m_PendingEnd = false;
+		m_Attributes = CXmlText();
+		m_Depth--;
+		return m_Event = EXE_EndElement;
+		}
+	while (m_Pos < m_End) {
+		if (*m_Pos != '<') { // Text
+			const char * pText = m_Pos;
+			m_Pos = (const char*)memchr(m_Pos, '<', m_End - m_Pos);
+			if (m_Pos == nullptr) m_Pos = m_End;
+			m_Text = CXmlText(pText, m_Pos - pText).trimmed();
+			if (m_Text.isEmpty())
+				continue;
+			return m_Event = EXE_Text;
+			}
+
+		const size_t remaining = m_End - m_Pos;
+		if (remaining >= 2 && m_Pos[1] == '?') { // Declaration
+			const char * p = find("?>");
+			if (p == nullptr) return setError();
+			m_Pos = p + 2;
+			continue;
+			}
+		if (remaining >= 4 && memcmp(m_Pos, "<!--", 4) == 0) {
+			const char * p = find("-->");
+			if (p == nullptr) return setError();
+			m_Pos = p + 3;
+			continue;
+			}
+		if (remaining >= 9 && memcmp(m_Pos, "<![CDATA[", 9) == 0) {
+			const char * p = find("]]>");
+			if (p == nullptr) return setError();
+			m_Text = CXmlText(m_Pos + 9, p - m_Pos - 9);
+			m_Pos  = p + 3;
+			return m_Event = EXE_Text;
+			}
+		if (remaining >= 2 && m_Pos[1] == '!') { // DOCTYPE
+			const char * p = (const char*)memchr(m_Pos, '>', remaining);
+			if (p == nullptr) return setError();
+			m_Pos = p + 1;
+			continue;
+			}
+
+		if (remaining >= 2 && m_Pos[1] == '/') { // End element
+			const char * p = (const char*)memchr(m_Pos, '>', remaining);
+			if (p == nullptr || m_Depth == 0) return setError();
+			m_Name = CXmlText(m_Pos + 2, p - m_Pos - 2).trimmed();
+			m_Attributes = CXmlText();
+			m_Pos = p + 1;
+			m_Depth--;
+			return m_Event = EXE_EndElement;
+			}
+
+		// Start element, ">" within quoted attribute values is allowed
+		const char * pName = m_Pos + 1;
+		const char * p     = pName;
+		while (p < m_End && !isSpace(*p) && *p != '>' && *p != '/') p++;
+		m_Name = CXmlText(pName, p - pName);
+		const char * pAttributes = p;
+		char quote = 0;
+		for (; p < m_End; p++) {
+			if (quote != 0)                  { if (*p == quote) quote = 0; }
+			else if (*p == '"' || *p == '\'')  quote = *p;
+			else if (*p == '>')              break;
+			}
+		if (p == m_End || m_Name.isEmpty()) return setError();
+		m_PendingEnd = (p[-1] == '/');
+		m_Attributes = CXmlText(pAttributes, (m_PendingEnd ? p - 1 : p) - pAttributes);
+		m_Pos = p + 1;
+		m_Depth++;
+		return m_Event = EXE_StartElement;
+		}
+	return m_Event = (m_Depth == 0) ? EXE_EndDocument : EXE_Error;
+}
+
+// -----------------------------------------------------------------------
+// name="value" resp. name='value', white space around "=" is allowed
+bool CXmlPullParser::getAttribute(const char * name, CXmlText & value) const {
+	const char * p   = m_Attributes.data;
+	const char * end = m_Attributes.data + m_Attributes.size;
+	while (p < end) {
+		while (p < end && isSpace(*p)) p++;
+		const char * pName = p;
+		while (p < end && !isSpace(*p) && *p != '=') p++;
+		const CXmlText attributeName(pName, p - pName);
+		while (p < end && isSpace(*p)) p++;
+		if (p == end || *p != '=')
+			return false;
+		p++;
+		while (p < end && isSpace(*p)) p++;
+		if (p == end || (*p != '"' && *p != '\''))
+			return false;
+		const char   quote  = *p++;
+		const char * pValue = p;
+		p = (const char*)memchr(p, quote, end - p);
+		if (p == nullptr)
+			return false;
+		if (attributeName.equals(name)) {
+			value = CXmlText(pValue, p - pValue);
+			return true;
+			}
+		p++;
+		}
+	return false;
+}
+
+// -----------------------------------------------------------------------
+// The first text directly within the element, empty if there is none
+bool CXmlPullParser::readElementText(CXmlText & text) {
+	if (m_Event != EXE_StartElement)
+		return false;
+	const int depth = m_Depth;
+	text = CXmlText();
+	while (next() != EXE_EndDocument && m_Event != EXE_Error) {
+		if (m_Event == EXE_Text && m_Depth == depth && text.isEmpty())
+			text = m_Text;
+		else if (m_Event == EXE_EndElement && m_Depth == depth - 1)
+			return true;
+		}
+	return false;
+}
+
+// -----------------------------------------------------------------------
+bool CXmlPullParser::skipElement() {
+	CXmlText text;
+	return readElementText(text);
+}
+
+}}} // End namespaces
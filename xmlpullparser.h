@@ -0,0 +1,107 @@
+#ifndef DE_BSWALZ_OLYCAMERARC_XMLPULLPARSER_H
+#define DE_BSWALZ_OLYCAMERARC_XMLPULLPARSER_H
+
+/**
+ * OlympusCamera-RemoteControl: parsing of the XML replies of the camera
+ *
+ * @copyright	2024 Siegfried Walz
+ * @license     https://www.gnu.org/licenses/lgpl-3.0.txt GNU Lesser General Public License
+ * @author      Siegfried Walz
+ * @link        https://software.bswalz.de/
+ * @package     OlyCamera-RC
+ */
+/*
+ * This file is part of OlyCamera-RC
+ *
+ * OlyCamera-RC is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * OlyCamera-RC is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OlyCamera-RC. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * OlyCamera-RC was tested under Android 4.1/5.0 (SDK 16/21) and Linux and
+ * was developped using Qt 5.12.12 resp. Qt 5.15.2 .
+ */
+
+
+#include <stddef.h>
+#include <string>
+
+namespace de { namespace bswalz { namespace olycamerarc {
+
+// -----------------------------------------------------------------------
+// Class CXmlText
+// Characters of the parsed buffer, not copied and not terminated. Valid as
+// long as the buffer is.
+// -----------------------------------------------------------------------
+class CXmlText {
+public:
+	CXmlText() : data(nullptr), size(0) {}
+	CXmlText(const char * pData, size_t length) : data(pData), size(length) {}
+
+	bool		isEmpty() const { return size == 0; }
+	bool		equals(const char * text) const;
+	bool		equals(const CXmlText & text) const;
+	bool		startsWith(const char * text) const;
+	/** Without leading and trailing white space */
+	CXmlText	trimmed() const;
+	std::string	toString() const { return std::string(data, size); }
+
+	const char *	data;
+	size_t			size;
+};
+
+// -----------------------------------------------------------------------
+// Class CXmlPullParser
+// Minimal non-validating XML pull parser for the replies of the camera.
+// Parses the buffer in place: names, attribute values and text refer to
+// the buffer, nothing is allocated or copied. Entities are not replaced,
+// the camera doesn't use them. Declarations, comments and DOCTYPE are
+// skipped, CDATA is returned as text, white space only text is skipped.
+// -----------------------------------------------------------------------
+class CXmlPullParser {
+public:
+	enum EEvent { EXE_StartElement, EXE_EndElement, EXE_Text, EXE_EndDocument, EXE_Error };
+
+	CXmlPullParser(const char * pData, size_t size);
+
+	/** Advances to the next event. A self-closing element is reported as start and end. */
+	EEvent		next();
+	EEvent		getEvent() const { return m_Event; }
+	/** Element name of EXE_StartElement/EXE_EndElement */
+	const CXmlText & getName() const { return m_Name; }
+	/** Trimmed text of EXE_Text */
+	const CXmlText & getText() const { return m_Text; }
+	/** Value of an attribute of the current start element */
+	bool		getAttribute(const char * name, CXmlText & value) const;
+	/** Number of open elements, e.g. 1 after the start of the root element */
+	int			getDepth() const { return m_Depth; }
+	/** Called at a start element: its text, consumes the element up to its end */
+	bool		readElementText(CXmlText & text);
+	/** Called at a start element: consumes the element up to its end */
+	bool		skipElement();
+
+private:
+	EEvent		setError() { m_Pos = m_End; return m_Event = EXE_Error; }
+	const char *	find(const char * text) const;
+
+	const char *	m_Pos;
+	const char *	m_End;
+	EEvent			m_Event;
+	CXmlText		m_Name;
+	CXmlText		m_Attributes;	// Between name and ">" resp. "/>"
+	CXmlText		m_Text;
+	int				m_Depth;
+	bool			m_PendingEnd;	// Of a self-closing element
+};
+
+}}} // End namespaces
+
+#endif // DE_BSWALZ_OLYCAMERARC_XMLPULLPARSER_H